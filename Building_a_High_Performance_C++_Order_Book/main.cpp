@@ -11,7 +11,131 @@ using clk = std::chrono::steady_clock;
 struct Event { uint8_t type; id_t id; px_t px; qty_t qty; Side side; };
 // type: 0=new, 1=amend, 2=del
 
+// 记录回调次数与最后一次L1
+struct L1Recorder {
+  uint64_t calls = 0;
+  L1 last;
+  void onL1(const L1& l1) { calls++; last = l1; }
+};
+
+// L1发布检查：删空/改量到0清掉最优价层也要发布，深层变化不发布
+bool checkL1Publish() {
+  int failures = 0;
+  auto check = [&](bool ok, const char* what) {
+    if (!ok) { std::printf("FAIL: %s\n", what); failures++; }
+  };
+  {
+    L1Recorder r; BasicOrderBook<L1Recorder&> ob(r);
+    ob.newOrder(Order{1,100,5,Side::Buy});
+    ob.newOrder(Order{2,101,3,Side::Buy});
+    ob.newOrder(Order{3,105,4,Side::Sell});
+    check(r.calls==3, "each new best publishes");
+    ob.deleteOrder(2);
+    check(r.calls==4 && r.last.bestBid==100 && r.last==ob.snapshotL1(), "deleting the only order at the best bid publishes");
+    ob.newOrder(Order{4,104,2,Side::Sell});
+    ob.amendOrder(4, -2);
+    check(r.calls==6 && r.last.bestAsk==105 && r.last==ob.snapshotL1(), "amending the best ask to zero publishes");
+    ob.newOrder(Order{5,99,7,Side::Buy});
+    ob.deleteOrder(5);
+    check(r.calls==6, "changes below the best do not publish");
+  }
+  {
+    L1Recorder r; BasicOrderBook<L1Recorder&> ob(r);
+    ob.newOrder(Order{1,100,5,Side::Buy});
+    ob.newOrder(Order{2,105,4,Side::Sell});
+    ob.newOrder(Order{3,101,3,Side::Buy});
+    const uint64_t before = r.calls;
+    ob.beginBatch();
+    ob.deleteOrder(3);
+    ob.endBatch();
+    check(r.calls==before+1 && r.last.bestBid==100 && r.last==ob.snapshotL1(), "batch that only cancels the top publishes once");
+  }
+  std::printf("L1 checks failed: %d\n", failures);
+  return failures==0;
+}
+
+// 回放整段事件流，返回平均ns/事件
+template <typename Book>
+double replay(Book& ob, const std::vector<Event>& evts) {
+  auto t1 = clk::now();
+  for (auto &e : evts) {
+    if (e.type==0) ob.newOrder(Order{e.id,e.px,e.qty,e.side});
+    else if (e.type==1) ob.amendOrder(e.id, (int32_t)e.qty);
+    else ob.deleteOrder(e.id);
+  }
+  auto t2 = clk::now();
+  return double(std::chrono::duration_cast<std::chrono::nanoseconds>(t2-t1).count()) / double(evts.size());
+}
+
+// 按包回放：每PACKET个事件包一批（beginBatch/endBatch）
+template <typename Book>
+double replayPackets(Book& ob, const std::vector<Event>& evts, size_t packet) {
+  auto t1 = clk::now();
+  for (size_t i=0;i<evts.size();i+=packet){
+    size_t end = std::min(evts.size(), i+packet);
+    ob.beginBatch();
+    for (size_t j=i;j<end;++j){
+      auto &e = evts[j];
+      if (e.type==0) ob.newOrder(Order{e.id,e.px,e.qty,e.side});
+      else if (e.type==1) ob.amendOrder(e.id, (int32_t)e.qty);
+      else ob.deleteOrder(e.id);
+    }
+    ob.endBatch();
+  }
+  auto t2 = clk::now();
+  return double(std::chrono::duration_cast<std::chrono::nanoseconds>(t2-t1).count()) / double(evts.size());
+}
+
+// L1合并对比：逐事件发布 vs 每包一次 vs 每包一次且仅在变化时
+void benchConflation(const std::vector<Event>& evts, size_t packet) {
+  using Book = BasicOrderBook<SpreadStrategy&>;
+  {
+    SpreadStrategy a; Book ob(a);
+    double ns = replay(ob, evts);
+    std::printf("L1 eager:                    %.2f ns/op, %llu callbacks\n", ns, (unsigned long long)a.updates);
+  }
+  {
+    SpreadStrategy a; Book ob(a);
+    double ns = replayPackets(ob, evts, packet);
+    std::printf("L1 conflated (%zu/packet):    %.2f ns/op, %llu callbacks\n", packet, ns, (unsigned long long)a.updates);
+  }
+  {
+    SpreadStrategy a; Book ob(a);
+    ob.setOnlyIfChanged(true);
+    double ns = replayPackets(ob, evts, packet);
+    std::printf("L1 conflated, only changed:  %.2f ns/op, %llu callbacks\n", ns, (unsigned long long)a.updates);
+  }
+}
+
+// 回调分发对比：同一事件流、三个策略，std::function vs 编译期订阅者
+void benchDispatch(const std::vector<Event>& evts) {
+  {
+    OrderBook ob;                          // 空std::function
+    std::printf("Dispatch none (std::function empty): %.2f ns/op\n", replay(ob, evts));
+  }
+  {
+    BasicOrderBook<> ob;                   // 无订阅者
+    std::printf("Dispatch none (no subscribers):      %.2f ns/op\n", replay(ob, evts));
+  }
+  {
+    SpreadStrategy a; ImbalanceStrategy b; MidStrategy c;
+    OrderBook ob([&](const L1& l1){ a.onL1(l1); b.onL1(l1); c.onL1(l1); });
+    double ns = replay(ob, evts);
+    std::printf("Dispatch std::function x3:           %.2f ns/op, %llu updates (chk %lld)\n",
+                ns, (unsigned long long)a.updates, (long long)(a.spreadSum + b.imbalance + c.midSum));
+  }
+  {
+    SpreadStrategy a; ImbalanceStrategy b; MidStrategy c;
+    BasicOrderBook<SpreadStrategy&, ImbalanceStrategy&, MidStrategy&> ob(a, b, c);
+    double ns = replay(ob, evts);
+    std::printf("Dispatch static subscribers x3:      %.2f ns/op, %llu updates (chk %lld)\n",
+                ns, (unsigned long long)a.updates, (long long)(a.spreadSum + b.imbalance + c.midSum));
+  }
+}
+
 int main() {
+  if (!checkL1Publish()) return 1;
+
   const size_t N = 10'000'000;           // 1e7事件
   const px_t pxMin=9900, pxMax=10100;    // 模拟价位区间
   const qty_t qMin=1, qMax=50;
@@ -106,5 +230,8 @@ int main() {
     if (!m99 && cum>=p99) m99=i;
   }
   std::printf("Latency per-op (batch-avg) ~ P50=%dns, P90=%dns, P99=%dns\n", m50, m90, m99);
+
+  benchDispatch(evts);
+  benchConflation(evts, 10);
   return int(sink^sinkq); // 防止优化器移除
 }
@@ -7,6 +7,9 @@
 #include <functional>
 #include <limits>
 #include <cassert>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 
 using id_t  = uint64_t;
 using px_t  = uint32_t;        // 价格按tick编码
@@ -33,12 +36,33 @@ struct L1 {                    // L1快照
   qty_t askQty{0};
 };
 
+inline bool operator==(const L1& a, const L1& b) {
+  return a.bestBid==b.bestBid && a.bestAsk==b.bestAsk && a.bidQty==b.bidQty && a.askQty==b.askQty;
+}
+inline bool operator!=(const L1& a, const L1& b) { return !(a==b); }
+
 // 订阅者：收到L1更新回调
 using L1Callback = std::function<void(const L1&)>;
 
-class OrderBook {
+// 把std::function包成订阅者（类型擦除，每次回调一次间接调用）
+struct FunctionSink {
+  L1Callback cb;
+  FunctionSink(L1Callback f = {}) : cb(std::move(f)) {}
+  void onL1(const L1& l1) { if (cb) cb(l1); }
+};
+
+// 订阅者在编译期确定：每个类型提供 void onL1(const L1&)，
+// 按模板参数顺序逐个调用，可内联，无间接调用/堆上捕获。
+// Subs可为引用类型（如 BasicOrderBook<Strat&>），回调到外部策略对象。
+template <typename... Subs>
+class BasicOrderBook {
 public:
-  explicit OrderBook(L1Callback cb = {}) : onL1_(std::move(cb)) {
+  // 不传实参（订阅者默认构造）或每个订阅者一个实参；
+  // 限定后不会抢走拷贝/移动构造（实参是book本身时不匹配）
+  template <typename... Args,
+            typename = std::enable_if_t<(sizeof...(Args)==0 || sizeof...(Args)==sizeof...(Subs)) &&
+                                        std::is_constructible<std::tuple<Subs...>, Args&&...>::value>>
+  explicit BasicOrderBook(Args&&... subs) : subs_(std::forward<Args>(subs)...) {
     id2idx_.reserve(1u<<20);   // 预留容量避免rehash
   }
 
@@ -125,22 +149,57 @@ public:
     return l1;
   }
 
+  // 合并（conflation）：批内触及顶簿只标脏，endBatch时发一次快照。
+  // 可嵌套，最外层endBatch才发布。一个行情包对应一批即可。
+  inline void beginBatch() { batchDepth_++; }
+  inline void endBatch() {
+    if (batchDepth_==0 || --batchDepth_>0 || !l1Dirty_) return;
+    l1Dirty_ = false;
+    const L1 l1 = snapshotL1();
+    if (onlyIfChanged_ && l1==lastL1_) return;   // 批内变化相互抵消
+    publishL1(l1);
+  }
+  // 批末快照与上次发布的相同则不回调（默认关闭）
+  inline void setOnlyIfChanged(bool on) { onlyIfChanged_ = on; }
+
+  // 第I个订阅者
+  template <size_t I>
+  auto& subscriber() { return std::get<I>(subs_); }
+
 private:
   struct Meta { px_t px; qty_t qty; Side side; };
   std::unordered_map<id_t, Meta> id2idx_; // id -> 元数据
   std::map<px_t, PriceLevel> bids_;       // 活跃买价层
   std::map<px_t, PriceLevel> asks_;       // 活跃卖价层
-  L1Callback onL1_;
+  std::tuple<Subs...> subs_;
+  L1 lastL1_;                             // 最近一次发布的L1
+  uint32_t batchDepth_{0};
+  bool l1Dirty_{false};
+  bool onlyIfChanged_{false};
+
+  inline void publishL1(const L1& l1) {
+    lastL1_ = l1;
+    std::apply([&](auto&... s) { (s.onL1(l1), ...); }, subs_);
+  }
+
+  inline void emitL1() {
+    if (batchDepth_) { l1Dirty_ = true; return; }   // 批内：延迟到endBatch
+    publishL1(snapshotL1());
+  }
 
   inline void maybeEmitL1(Side changedSide, px_t changedPx) {
-    if (!onL1_) return;
-    // 仅在影响bestBid/bestAsk时回调（O(1)取端点）
+    if constexpr (sizeof...(Subs)==0) return;   // 无订阅者：连快照都不构建
+    // 仅在影响bestBid/bestAsk时回调（O(1)取端点）。
+    // 最优价层被删空时变化价位已不在树中，且优于新的最优价，故用>=/<=比较
     if (changedSide==Side::Buy) {
-      if (bids_.empty() || asks_.empty()) { onL1_(snapshotL1()); return; }
-      if (changedPx==bids_.rbegin()->first) onL1_(snapshotL1());
+      if (bids_.empty() || asks_.empty()) { emitL1(); return; }
+      if (changedPx>=bids_.rbegin()->first) emitL1();
     } else {
-      if (bids_.empty() || asks_.empty()) { onL1_(snapshotL1()); return; }
-      if (changedPx==asks_.begin()->first) onL1_(snapshotL1());
+      if (bids_.empty() || asks_.empty()) { emitL1(); return; }
+      if (changedPx<=asks_.begin()->first) emitL1();
     }
   }
 };
+
+// 原接口：单个std::function回调
+using OrderBook = BasicOrderBook<FunctionSink>;
@@ -10,3 +10,25 @@ struct PrintStrategy {
       l1.bestBid, l1.bidQty, l1.bestAsk, l1.askQty);
   }
 };
+
+// 基准用的轻量策略：只做累加，不打印
+struct SpreadStrategy {
+  uint64_t updates{0};
+  uint64_t spreadSum{0};
+  void onL1(const L1& l1) {
+    updates++;
+    if (l1.bestAsk > l1.bestBid) spreadSum += l1.bestAsk - l1.bestBid;
+  }
+};
+
+struct ImbalanceStrategy {
+  int64_t imbalance{0};
+  void onL1(const L1& l1) { imbalance += int64_t(l1.bidQty) - int64_t(l1.askQty); }
+};
+
+struct MidStrategy {
+  uint64_t midSum{0};
+  void onL1(const L1& l1) {
+    if (l1.bidQty && l1.askQty) midSum += (uint64_t(l1.bestBid) + l1.bestAsk) / 2;
+  }
+};
@@ -0,0 +1,63 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+
+// Replaces the global operator new/delete to keep a running total of heap
+// bytes in use, so benchmarks can report resident bytes per order. Sizes come
+// from the allocator itself (rounding included), so no per-block header is
+// added. Include from exactly one translation unit (main.cpp): the
+// replacement operators are ordinary, non-inline definitions. Over-aligned
+// (align_val_t) allocations keep the library versions and are not counted.
+
+namespace memstats {
+
+inline std::atomic<long long>& liveBytesCounter() {
+    static std::atomic<long long> bytes{0};
+    return bytes;
+}
+
+inline long long liveBytes() {
+    return liveBytesCounter().load(std::memory_order_relaxed);
+}
+
+inline size_t blockSize(void* p) {
+#if defined(_WIN32)
+    return _msize(p);
+#elif defined(__APPLE__)
+    return malloc_size(p);
+#else
+    return malloc_usable_size(p);
+#endif
+}
+
+inline void* allocate(size_t size) {
+    void* p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    liveBytesCounter().fetch_add(static_cast<long long>(blockSize(p)), std::memory_order_relaxed);
+    return p;
+}
+
+inline void release(void* p) noexcept {
+    if (!p) return;
+    liveBytesCounter().fetch_sub(static_cast<long long>(blockSize(p)), std::memory_order_relaxed);
+    std::free(p);
+}
+
+}  // namespace memstats
+
+void* operator new(size_t size) { return memstats::allocate(size); }
+void* operator new[](size_t size) { return memstats::allocate(size); }
+void operator delete(void* p) noexcept { memstats::release(p); }
+void operator delete[](void* p) noexcept { memstats::release(p); }
+void operator delete(void* p, size_t) noexcept { memstats::release(p); }
+void operator delete[](void* p, size_t) noexcept { memstats::release(p); }
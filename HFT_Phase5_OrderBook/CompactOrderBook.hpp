@@ -0,0 +1,289 @@
+#pragma once
+#include "OrderBook.hpp"
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+// One order, stored once. Ids of up to INLINE_ID bytes live in the record;
+// longer ids go to the book's overflow arena and the id field holds their
+// offset and length instead.
+struct CompactOrder {
+    static constexpr size_t INLINE_ID = 18;
+    static constexpr uint8_t IS_BUY = 1;
+    static constexpr uint8_t LONG_ID = 2;
+
+    double price;
+    int32_t quantity;
+    uint8_t flags;
+    uint8_t idLength;        // inline ids only
+    char id[INLINE_ID];      // inline id, or {uint64_t offset, uint32_t length}
+
+    bool isBuy() const { return flags & IS_BUY; }
+};
+
+static_assert(sizeof(CompactOrder) == 32, "CompactOrder should fill half a cache line");
+
+// What forEachOrder hands out; the id points into the book.
+struct CompactOrderView {
+    std::string_view id;
+    double price;
+    int quantity;
+    bool isBuy;
+};
+
+
+// ================================
+// Memory-lean book: orders are packed 32-byte records in one vector (swap-
+// remove on delete, like OptimizedOrderBook's pool), and the id index is an
+// open-addressing table of 4-byte record handles, so no id is stored twice.
+// Price levels are per-side aggregates found by price, not per-order refs.
+class CompactOrderBook {
+private:
+    using LevelMap = std::map<double, PriceLevelInfo>;
+
+    static constexpr uint32_t EMPTY = 0;  // slots hold record index + 1
+
+    std::vector<CompactOrder> records;
+    std::vector<uint32_t> slots;          // power-of-two size, linear probing
+    std::vector<char> longIds;
+    size_t deadLongIdBytes = 0;
+    LevelMap bidLevels;
+    LevelMap askLevels;
+
+public:
+    CompactOrderBook(size_t reserveSize = 100000) {
+        records.reserve(reserveSize);
+        slots.assign(tableSizeFor(reserveSize), EMPTY);
+    }
+
+    void addOrder(const std::string& id, double price, int quantity, bool isBuy) {
+        if (findSlot(id) != NOT_FOUND) {
+            std::cerr << "Duplicate order ID: " << id << std::endl;
+            return;
+        }
+        if ((records.size() + 1) * 10 > slots.size() * 7) {
+            rehash(slots.size() * 2);
+        }
+        CompactOrder record{};
+        record.price = price;
+        record.quantity = quantity;
+        record.flags = isBuy ? CompactOrder::IS_BUY : 0;
+        storeId(record, id);
+        records.push_back(record);
+        insertSlot(id, static_cast<uint32_t>(records.size()));
+        joinLevel(price, quantity, isBuy);
+    }
+
+    void addOrders(const Order* orders, size_t count) {
+        records.reserve(records.size() + count);
+        if ((records.size() + count) * 10 > slots.size() * 7) {
+            rehash(tableSizeFor(records.size() + count));
+        }
+        for (size_t i = 0; i < count; i++) {
+            addOrder(orders[i].id, orders[i].price, orders[i].quantity, orders[i].isBuy);
+        }
+    }
+
+    void modifyOrder(const std::string& id, double newPrice, int newQuantity) {
+        size_t slot = findSlot(id);
+        if (slot != NOT_FOUND) {
+            CompactOrder& record = records[slots[slot] - 1];
+            LevelMap& levels = record.isBuy() ? bidLevels : askLevels;
+            if (record.price == newPrice) {
+                levels.find(newPrice)->second.totalQuantity += newQuantity - record.quantity;
+            }
+            else {
+                leaveLevel(record.price, record.quantity, record.isBuy());
+                joinLevel(newPrice, newQuantity, record.isBuy());
+            }
+            record.price = newPrice;
+            record.quantity = newQuantity;
+        }
+    }
+
+    void deleteOrder(const std::string& id) {
+        size_t slot = findSlot(id);
+        if (slot == NOT_FOUND) {
+            return;
+        }
+        size_t index = slots[slot] - 1;
+        CompactOrder& record = records[index];
+        leaveLevel(record.price, record.quantity, record.isBuy());
+        if (record.flags & CompactOrder::LONG_ID) {
+            deadLongIdBytes += idOf(record).size();
+        }
+        eraseSlot(slot);
+
+        if (index + 1 != records.size()) {
+            // The last record moves into the hole; repoint its slot.
+            records[index] = records.back();
+            size_t moved = findSlot(idOf(records[index]));
+            slots[moved] = static_cast<uint32_t>(index + 1);
+        }
+        records.pop_back();
+
+        if (deadLongIdBytes > 4096 && deadLongIdBytes * 2 > longIds.size()) {
+            compactLongIds();
+        }
+    }
+
+    bool findOrder(const std::string& id) const {
+        return findSlot(id) != NOT_FOUND;
+    }
+
+    int getOrderCount() const {
+        return static_cast<int>(records.size());
+    }
+
+    bool getBestBid(PriceLevelInfo& out) const {
+        if (bidLevels.empty()) return false;
+        out = bidLevels.rbegin()->second;
+        return true;
+    }
+
+    bool getBestAsk(PriceLevelInfo& out) const {
+        if (askLevels.empty()) return false;
+        out = askLevels.begin()->second;
+        return true;
+    }
+
+    size_t levelCount(bool isBuy) const {
+        return isBuy ? bidLevels.size() : askLevels.size();
+    }
+
+    // Visits orders in record order.
+    template <typename Fn>
+    void forEachOrder(Fn fn) const {
+        for (const CompactOrder& record : records) {
+            fn(CompactOrderView{idOf(record), record.price, record.quantity, record.isBuy()});
+        }
+    }
+
+    void restoreFrom(const SnapshotImage& image) {
+        records.clear();
+        longIds.clear();
+        deadLongIdBytes = 0;
+        bidLevels.clear();
+        askLevels.clear();
+        records.reserve(image.size());
+        slots.assign(tableSizeFor(image.size()), EMPTY);
+        for (size_t i = 0; i < image.size(); i++) {
+            const SnapshotRecord& r = image.record(i);
+            addOrder(std::string(image.id(i)), r.price, r.quantity, r.isBuy != 0);
+        }
+    }
+
+private:
+    static constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+
+    // Smallest power of two keeping n entries under a 0.7 load factor.
+    static size_t tableSizeFor(size_t n) {
+        size_t size = 16;
+        while (n * 10 > size * 7) size *= 2;
+        return size;
+    }
+
+    static size_t hashId(std::string_view id) {
+        return std::hash<std::string_view>{}(id);
+    }
+
+    std::string_view idOf(const CompactOrder& record) const {
+        if (record.flags & CompactOrder::LONG_ID) {
+            uint64_t offset;
+            uint32_t length;
+            std::memcpy(&offset, record.id, sizeof(offset));
+            std::memcpy(&length, record.id + sizeof(offset), sizeof(length));
+            return std::string_view(longIds.data() + offset, length);
+        }
+        return std::string_view(record.id, record.idLength);
+    }
+
+    void storeId(CompactOrder& record, std::string_view id) {
+        if (id.size() <= CompactOrder::INLINE_ID) {
+            std::memcpy(record.id, id.data(), id.size());
+            record.idLength = static_cast<uint8_t>(id.size());
+            return;
+        }
+        uint64_t offset = longIds.size();
+        uint32_t length = static_cast<uint32_t>(id.size());
+        longIds.insert(longIds.end(), id.begin(), id.end());
+        record.flags |= CompactOrder::LONG_ID;
+        std::memcpy(record.id, &offset, sizeof(offset));
+        std::memcpy(record.id + sizeof(offset), &length, sizeof(length));
+    }
+
+    // Rewrites the arena with only the live long ids.
+    void compactLongIds() {
+        std::vector<char> live;
+        live.reserve(longIds.size() - deadLongIdBytes);
+        for (CompactOrder& record : records) {
+            if (record.flags & CompactOrder::LONG_ID) {
+                std::string_view id = idOf(record);
+                uint64_t offset = live.size();
+                live.insert(live.end(), id.begin(), id.end());
+                std::memcpy(record.id, &offset, sizeof(offset));
+            }
+        }
+        longIds.swap(live);
+        deadLongIdBytes = 0;
+    }
+
+    size_t findSlot(std::string_view id) const {
+        const size_t mask = slots.size() - 1;
+        for (size_t i = hashId(id) & mask;; i = (i + 1) & mask) {
+            if (slots[i] == EMPTY) return NOT_FOUND;
+            if (idOf(records[slots[i] - 1]) == id) return i;
+        }
+    }
+
+    void insertSlot(std::string_view id, uint32_t handle) {
+        const size_t mask = slots.size() - 1;
+        size_t i = hashId(id) & mask;
+        while (slots[i] != EMPTY) i = (i + 1) & mask;
+        slots[i] = handle;
+    }
+
+    // Backward-shift deletion: later entries of the probe run move up so no
+    // tombstones are needed.
+    void eraseSlot(size_t hole) {
+        const size_t mask = slots.size() - 1;
+        for (size_t i = (hole + 1) & mask; slots[i] != EMPTY; i = (i + 1) & mask) {
+            size_t home = hashId(idOf(records[slots[i] - 1])) & mask;
+            // Move entry i into the hole unless its home lies cyclically in (hole, i].
+            if (((i - home) & mask) >= ((i - hole) & mask)) {
+                slots[hole] = slots[i];
+                hole = i;
+            }
+        }
+        slots[hole] = EMPTY;
+    }
+
+    void rehash(size_t newSize) {
+        slots.assign(newSize, EMPTY);
+        for (size_t i = 0; i < records.size(); i++) {
+            insertSlot(idOf(records[i]), static_cast<uint32_t>(i + 1));
+        }
+    }
+
+    void joinLevel(double price, int quantity, bool isBuy) {
+        LevelMap& levels = isBuy ? bidLevels : askLevels;
+        auto it = levels.try_emplace(price, PriceLevelInfo{price, 0, 0}).first;
+        it->second.totalQuantity += quantity;
+        it->second.orderCount++;
+    }
+
+    void leaveLevel(double price, int quantity, bool isBuy) {
+        LevelMap& levels = isBuy ? bidLevels : askLevels;
+        auto it = levels.find(price);
+        it->second.totalQuantity -= quantity;
+        if (--it->second.orderCount == 0) {
+            levels.erase(it);
+        }
+    }
+};
@@ -1,3 +1,4 @@
+#pragma once
 #include <iostream>
 #include <map>
 #include <unordered_map>
@@ -5,6 +6,10 @@
 #include <chrono>
 #include <vector>
 #include <atomic>
+#include <cstdint>
+#include <algorithm>
+#include "SimdKernels.hpp"
+#include "OrderBookSnapshot.hpp"
 
 
 struct Order {
@@ -14,10 +19,25 @@ struct Order {
     bool isBuy;
 };
 
+// Aggregated view of one price level on one side of the book
+struct PriceLevelInfo {
+    double price;
+    long long totalQuantity;
+    int orderCount;
+};
+
 class OrderBook {
 private:
-    std::map<double, std::unordered_map<std::string, Order>> orderLevels;
+    using Level = std::unordered_map<std::string, Order>;
+    using LevelMap = std::map<double, Level>;
+
+    // Emptied levels are detached from the map and kept here (with their
+    // bucket arrays) so a new price can reuse them without allocating.
+    static constexpr size_t MAX_POOLED_LEVELS = 1024;
+
+    LevelMap orderLevels;
     std::unordered_map<std::string, Order> orderLookup;
+    std::vector<LevelMap::node_type> levelPool;
 
 public:
 
@@ -26,16 +46,95 @@ public:
         return orderLookup.find(id) != orderLookup.end();
     }
 
+    size_t levelCount() const {
+        return orderLevels.size();
+    }
+
+    // Visits orders level by level in ascending price order.
+    template <typename Fn>
+    void forEachOrder(Fn fn) const {
+        for (const auto& level : orderLevels) {
+            for (const auto& entry : level.second) {
+                fn(entry.second);
+            }
+        }
+    }
+
+    // Replaces the book's contents with a snapshot image. Records written by
+    // saveSnapshot(OrderBook) are price-ordered, so each level is looked up
+    // once and the lookup table is sized up front.
+    void restoreFrom(const SnapshotImage& image) {
+        orderLevels.clear();
+        orderLookup.clear();
+        orderLookup.reserve(image.size());
+        Level* level = nullptr;
+        double levelPrice = 0.0;
+        for (size_t i = 0; i < image.size(); i++) {
+            const SnapshotRecord& r = image.record(i);
+            if (!level || r.price != levelPrice) {
+                level = &acquireLevel(r.price);
+                levelPrice = r.price;
+            }
+            Order order = {std::string(image.id(i)), r.price, r.quantity, r.isBuy != 0};
+            (*level)[order.id] = order;
+            orderLookup.emplace(order.id, std::move(order));
+        }
+    }
+
     void addOrder(const std::string& id, double price, int quantity, bool isBuy) {
         Order order = {id, price, quantity, isBuy};
-        orderLevels[price][id] = order;
+        acquireLevel(price)[id] = order;
         orderLookup[id] = order;
     }
+
+    // Bulk load (e.g. the opening book). Orders are sorted by price once so
+    // each level is looked up and sized a single time, and the lookup table
+    // is reserved for the final count. Ids are expected to be new to the book.
+    void addOrders(const Order* orders, size_t count) {
+        std::vector<const Order*> sorted(count);
+        for (size_t i = 0; i < count; i++) sorted[i] = &orders[i];
+        std::stable_sort(sorted.begin(), sorted.end(),
+                         [](const Order* a, const Order* b) { return a->price < b->price; });
+
+        orderLookup.reserve(orderLookup.size() + count);
+        for (size_t first = 0; first < count;) {
+            const double price = sorted[first]->price;
+            size_t last = first + 1;
+            while (last < count && sorted[last]->price == price) last++;
+
+            Level& level = acquireLevel(price);
+            level.reserve(level.size() + (last - first));
+            for (; first < last; first++) {
+                const Order& order = *sorted[first];
+                level[order.id] = order;
+                orderLookup[order.id] = order;
+            }
+        }
+    }
+
+    void addOrders(const std::vector<Order>& orders) {
+        addOrders(orders.data(), orders.size());
+    }
+
+    // Quantity-only amends are done in place; a price amend moves the order's
+    // node from the old level to the new one without re-inserting it.
     void modifyOrder(const std::string& id, double newPrice, int newQuantity) {
-        if (orderLookup.find(id) != orderLookup.end()) {
-            Order oldOrder = orderLookup[id];
-            orderLevels[oldOrder.price].erase(id);  
-            addOrder(id, newPrice, newQuantity, oldOrder.isBuy);
+        auto it = orderLookup.find(id);
+        if (it != orderLookup.end()) {
+            Order& order = it->second;
+            auto levelIt = orderLevels.find(order.price);
+            if (newPrice == order.price) {
+                levelIt->second.find(id)->second.quantity = newQuantity;
+            }
+            else {
+                auto node = levelIt->second.extract(id);
+                node.mapped().price = newPrice;
+                node.mapped().quantity = newQuantity;
+                releaseLevelIfEmpty(levelIt);
+                acquireLevel(newPrice).insert(std::move(node));
+            }
+            order.price = newPrice;
+            order.quantity = newQuantity;
         }
         else {
             std::cerr << "Order ID not found: " << id << std::endl;
@@ -43,10 +142,12 @@ public:
     }
 
     void deleteOrder(const std::string& id) {
-        if (orderLookup.find(id) != orderLookup.end()) {
-            Order order = orderLookup[id];
-            orderLevels[order.price].erase(id);  
-            orderLookup.erase(id);
+        auto it = orderLookup.find(id);
+        if (it != orderLookup.end()) {
+            auto levelIt = orderLevels.find(it->second.price);
+            levelIt->second.erase(id);
+            releaseLevelIfEmpty(levelIt);
+            orderLookup.erase(it);
         }
         else {
             std::cerr << "Order ID not found: " << id << std::endl;
@@ -63,54 +164,289 @@ public:
         
         std::cout << "Execution time: " << elapsed.count() << " seconds" << std::endl;
     }
+
+private:
+    Level& acquireLevel(double price) {
+        auto it = orderLevels.lower_bound(price);
+        if (it != orderLevels.end() && it->first == price) {
+            return it->second;
+        }
+        if (levelPool.empty()) {
+            return orderLevels.emplace_hint(it, price, Level{})->second;
+        }
+        LevelMap::node_type node = std::move(levelPool.back());
+        levelPool.pop_back();
+        node.key() = price;
+        return orderLevels.insert(it, std::move(node))->second;
+    }
+
+    void releaseLevelIfEmpty(LevelMap::iterator levelIt) {
+        if (!levelIt->second.empty()) {
+            return;
+        }
+        LevelMap::node_type node = orderLevels.extract(levelIt);
+        if (levelPool.size() < MAX_POOLED_LEVELS) {
+            levelPool.push_back(std::move(node));
+        }
+    }
 };
 
 
 // ================================
 class OptimizedOrderBook {
+public:
+    // Columnar keeps price, quantity and side columns parallel to orderPool
+    // (same index, same swap-remove) so book-wide aggregation can use the
+    // SIMD kernels instead of walking Order structs.
+    enum class StorageMode { Rows, Columnar };
+
 private:
+    // Per-side price levels kept alongside the pool. Both sides share one map
+    // type so the pool can hold a level iterator per order; best bid is the
+    // last bid level and best ask the first ask level.
+    using LevelMap = std::map<double, PriceLevelInfo>;
+
+    // orderMap, levelRefs and the level maps are the book's index. After
+    // restoreFrom() they are left empty until ensureIndex() rebuilds them, so
+    // a restored book can be iterated and aggregated straight away.
     std::vector<Order> orderPool;
+    std::vector<LevelMap::iterator> levelRefs;  // parallel to orderPool
     std::unordered_map<std::string, size_t> orderMap;
+    LevelMap bidLevels;
+    LevelMap askLevels;
+    bool indexStale = false;
     std::atomic<int> orderCount{0}; 
 
+    StorageMode mode;
+    std::vector<double> priceColumn;
+    std::vector<int> quantityColumn;
+    std::vector<uint8_t> isBuyColumn;
+
 public:
-    OptimizedOrderBook(size_t reserveSize = 100000) {
+    OptimizedOrderBook(size_t reserveSize = 100000, StorageMode storageMode = StorageMode::Rows)
+        : mode(storageMode) {
         orderPool.reserve(reserveSize);
+        levelRefs.reserve(reserveSize);
         orderMap.reserve(reserveSize);
+        if (mode == StorageMode::Columnar) {
+            priceColumn.reserve(reserveSize);
+            quantityColumn.reserve(reserveSize);
+            isBuyColumn.reserve(reserveSize);
+        }
     }
 
     void addOrder(const std::string& id, double price, int quantity, bool isBuy) {
+        ensureIndex();
         Order order = {id, price, quantity, isBuy};
         orderPool.push_back(order);
+        levelRefs.push_back(joinLevel(price, quantity, isBuy));
+        if (mode == StorageMode::Columnar) {
+            priceColumn.push_back(price);
+            quantityColumn.push_back(quantity);
+            isBuyColumn.push_back(isBuy);
+        }
         orderMap[id] = orderPool.size() - 1;
         orderCount.fetch_add(1, std::memory_order_relaxed);
     }
 
+    // Bulk load (e.g. the opening book). The pool, columns and orderMap are
+    // grown once to their final size, and price levels are built from one
+    // sort of the new orders instead of a map lookup per order. Ids are
+    // expected to be new to the book.
+    void addOrders(const Order* orders, size_t count) {
+        ensureIndex();
+        const size_t first = orderPool.size();
+        orderPool.reserve(first + count);
+        orderPool.insert(orderPool.end(), orders, orders + count);
+        if (mode == StorageMode::Columnar) {
+            priceColumn.reserve(first + count);
+            quantityColumn.reserve(first + count);
+            isBuyColumn.reserve(first + count);
+            for (size_t i = 0; i < count; i++) {
+                priceColumn.push_back(orders[i].price);
+                quantityColumn.push_back(orders[i].quantity);
+                isBuyColumn.push_back(orders[i].isBuy);
+            }
+        }
+        indexFrom(first);
+        orderCount.fetch_add(static_cast<int>(count), std::memory_order_relaxed);
+    }
+
+    void addOrders(const std::vector<Order>& orders) {
+        addOrders(orders.data(), orders.size());
+    }
+
     void modifyOrder(const std::string& id, double newPrice, int newQuantity) {
-        if (orderMap.find(id) != orderMap.end()) {
-            size_t index = orderMap[id];
-            orderPool[index].price = newPrice;
-            orderPool[index].quantity = newQuantity;
+        ensureIndex();
+        auto it = orderMap.find(id);
+        if (it != orderMap.end()) {
+            size_t index = it->second;
+            Order& order = orderPool[index];
+            if (order.price == newPrice) {
+                // Same level: adjust the aggregate in place, no map lookup
+                levelRefs[index]->second.totalQuantity += newQuantity - order.quantity;
+            }
+            else {
+                leaveLevel(levelRefs[index], order.quantity, order.isBuy);
+                levelRefs[index] = joinLevel(newPrice, newQuantity, order.isBuy);
+            }
+            order.price = newPrice;
+            order.quantity = newQuantity;
+            if (mode == StorageMode::Columnar) {
+                priceColumn[index] = newPrice;
+                quantityColumn[index] = newQuantity;
+            }
         }
     }
 
     void deleteOrder(const std::string& id) {
-        if (orderMap.find(id) != orderMap.end()) {
-            size_t index = orderMap[id];
-            orderPool[index] = orderPool.back();
-            orderMap[orderPool[index].id] = index;
+        ensureIndex();
+        auto it = orderMap.find(id);
+        if (it != orderMap.end()) {
+            size_t index = it->second;
+            leaveLevel(levelRefs[index], orderPool[index].quantity, orderPool[index].isBuy);
+            if (index + 1 != orderPool.size()) {
+                orderPool[index] = std::move(orderPool.back());
+                orderMap[orderPool[index].id] = index;
+            }
+            levelRefs[index] = levelRefs.back();
             orderPool.pop_back();
+            levelRefs.pop_back();
+            if (mode == StorageMode::Columnar) {
+                priceColumn[index] = priceColumn.back();
+                quantityColumn[index] = quantityColumn.back();
+                isBuyColumn[index] = isBuyColumn.back();
+                priceColumn.pop_back();
+                quantityColumn.pop_back();
+                isBuyColumn.pop_back();
+            }
             orderMap.erase(id);
             orderCount.fetch_sub(1, std::memory_order_relaxed);
         }
     }
 
-
+    // The const readers below use the index as is: after restoreFrom(),
+    // call ensureIndex() before them. Mutators rebuild it themselves.
     bool findOrder(const std::string& id) const {
         return orderMap.find(id) != orderMap.end();
     }
 
+    int getOrderCount() const {
+        return orderCount.load(std::memory_order_relaxed);
+    }
+
+    // O(1): highest bid level. Returns false if there are no bids.
+    bool getBestBid(PriceLevelInfo& out) const {
+        if (bidLevels.empty()) return false;
+        out = bidLevels.rbegin()->second;
+        return true;
+    }
+
+    // O(1): lowest ask level. Returns false if there are no asks.
+    bool getBestAsk(PriceLevelInfo& out) const {
+        if (askLevels.empty()) return false;
+        out = askLevels.begin()->second;
+        return true;
+    }
+
+    // Copies up to maxLevels levels of one side, best first, into out.
+    // Returns the number of levels written. O(maxLevels).
+    size_t getDepth(bool isBuy, PriceLevelInfo* out, size_t maxLevels) const {
+        size_t n = 0;
+        if (isBuy) {
+            for (auto it = bidLevels.rbegin(); it != bidLevels.rend() && n < maxLevels; ++it) {
+                out[n++] = it->second;
+            }
+        }
+        else {
+            for (auto it = askLevels.begin(); it != askLevels.end() && n < maxLevels; ++it) {
+                out[n++] = it->second;
+            }
+        }
+        return n;
+    }
+
+    size_t levelCount(bool isBuy) const {
+        return isBuy ? bidLevels.size() : askLevels.size();
+    }
+
+    StorageMode storageMode() const {
+        return mode;
+    }
+
+    // Visits orders in pool order.
+    template <typename Fn>
+    void forEachOrder(Fn fn) const {
+        for (const Order& order : orderPool) {
+            fn(order);
+        }
+    }
+
+    // Replaces the book's contents with a snapshot image. Only the pool (and
+    // columns) are filled here; orderMap and the price levels are rebuilt by
+    // ensureIndex(), or by the first mutator.
+    void restoreFrom(const SnapshotImage& image) {
+        const size_t n = image.size();
+        orderPool.clear();
+        orderPool.reserve(n);
+        priceColumn.clear();
+        quantityColumn.clear();
+        isBuyColumn.clear();
+        for (size_t i = 0; i < n; i++) {
+            const SnapshotRecord& r = image.record(i);
+            orderPool.push_back(Order{std::string(image.id(i)), r.price, r.quantity, r.isBuy != 0});
+        }
+        if (mode == StorageMode::Columnar) {
+            priceColumn.reserve(n);
+            quantityColumn.reserve(n);
+            isBuyColumn.reserve(n);
+            for (const Order& order : orderPool) {
+                priceColumn.push_back(order.price);
+                quantityColumn.push_back(order.quantity);
+                isBuyColumn.push_back(order.isBuy);
+            }
+        }
+        orderMap.clear();
+        levelRefs.clear();
+        bidLevels.clear();
+        askLevels.clear();
+        indexStale = true;
+        orderCount.store(static_cast<int>(n), std::memory_order_relaxed);
+    }
+
+    void ensureIndex() {
+        if (indexStale) {
+            rebuildIndex();
+        }
+    }
+
+    // Notional, per-side exposure and VWAP over every live order. Columnar
+    // books use the widest SIMD kernel the CPU supports; row books walk the pool.
+    ExposureSummary computeExposure() const {
+        if (mode == StorageMode::Columnar) {
+            return simd::exposure(priceColumn.data(), quantityColumn.data(), isBuyColumn.data(), priceColumn.size());
+        }
+        ExposureSummary r{0.0, 0.0, 0, 0};
+        for (const Order& order : orderPool) {
+            double notional = order.price * order.quantity;
+            if (order.isBuy) {
+                r.buyNotional += notional;
+                r.buyQuantity += order.quantity;
+            }
+            else {
+                r.sellNotional += notional;
+                r.sellQuantity += order.quantity;
+            }
+        }
+        return r;
+    }
+
     void processOrders() {
+        if (mode == StorageMode::Columnar) {
+            volatile double dummy = computeExposure().notional();
+            (void)dummy;
+            return;
+        }
         size_t n = orderPool.size();
         for (size_t i = 0; i < n; i += 2) {
             handleOrder(orderPool[i]);
@@ -123,4 +459,68 @@ private:
         volatile double dummy = order.price * order.quantity;
         (void)dummy;
     }
+
+    void rebuildIndex() {
+        indexStale = false;
+        indexFrom(0);
+    }
+
+    // Indexes pool entries [first, end): orderMap entries plus price levels.
+    // The new entries are sorted by price per side, so each distinct price
+    // costs one level insert (hinted, so appending to an empty side never
+    // searches the map) rather than one lookup per order.
+    void indexFrom(size_t first) {
+        struct LoadKey {
+            double price;
+            size_t index;
+        };
+        const size_t last = orderPool.size();
+        std::vector<LoadKey> bids, asks;
+        for (size_t i = first; i < last; i++) {
+            (orderPool[i].isBuy ? bids : asks).push_back(LoadKey{orderPool[i].price, i});
+        }
+
+        orderMap.reserve(last);
+        levelRefs.resize(last);
+        for (size_t i = first; i < last; i++) {
+            orderMap[orderPool[i].id] = i;
+        }
+
+        for (int side = 0; side < 2; side++) {
+            std::vector<LoadKey>& keys = side == 0 ? bids : asks;
+            LevelMap& levels = side == 0 ? bidLevels : askLevels;
+            std::sort(keys.begin(), keys.end(),
+                      [](const LoadKey& a, const LoadKey& b) { return a.price < b.price; });
+
+            auto hint = levels.begin();
+            for (size_t k = 0; k < keys.size();) {
+                const double price = keys[k].price;
+                if (hint != levels.end() && hint->first < price) {
+                    hint = levels.lower_bound(price);
+                }
+                auto level = levels.try_emplace(hint, price, PriceLevelInfo{price, 0, 0});
+                for (; k < keys.size() && keys[k].price == price; k++) {
+                    level->second.totalQuantity += orderPool[keys[k].index].quantity;
+                    level->second.orderCount++;
+                    levelRefs[keys[k].index] = level;
+                }
+                hint = std::next(level);
+            }
+        }
+    }
+
+    LevelMap::iterator joinLevel(double price, int quantity, bool isBuy) {
+        LevelMap& levels = isBuy ? bidLevels : askLevels;
+        auto it = levels.try_emplace(price, PriceLevelInfo{price, 0, 0}).first;
+        it->second.totalQuantity += quantity;
+        it->second.orderCount++;
+        return it;
+    }
+
+    void leaveLevel(LevelMap::iterator it, int quantity, bool isBuy) {
+        it->second.totalQuantity -= quantity;
+        if (--it->second.orderCount == 0) {
+            (isBuy ? bidLevels : askLevels).erase(it);
+        }
+    }
 };
\ No newline at end of file
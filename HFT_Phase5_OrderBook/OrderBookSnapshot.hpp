@@ -0,0 +1,199 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+// ================================
+// Binary book image. Everything after the header is addressed by offsets from
+// the start of the file, so the image is valid wherever it gets mapped:
+//
+//   SnapshotHeader | SnapshotRecord[orderCount] | id bytes
+//
+// Records are written in the order the book hands them out (price order for
+// OrderBook, pool order for OptimizedOrderBook) so restores can rebuild their
+// containers with append-only inserts.
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t orderCount;
+    uint64_t recordsOffset;
+    uint64_t idsOffset;
+    uint64_t idsBytes;
+};
+
+struct SnapshotRecord {
+    double price;
+    uint64_t idOffset;   // relative to SnapshotHeader::idsOffset
+    uint32_t idLength;
+    int32_t quantity;
+    uint8_t isBuy;
+    uint8_t reserved[7];
+};
+
+static_assert(sizeof(SnapshotHeader) == 48, "SnapshotHeader layout is part of the file format");
+static_assert(sizeof(SnapshotRecord) == 32, "SnapshotRecord layout is part of the file format");
+
+constexpr char SNAPSHOT_MAGIC[8] = {'O', 'B', 'S', 'N', 'A', 'P', '\0', '\0'};
+constexpr uint32_t SNAPSHOT_VERSION = 1;
+
+// Writes every order of book (anything with forEachOrder) to path.
+template <typename Book>
+bool saveSnapshot(const Book& book, const std::string& path) {
+    std::vector<SnapshotRecord> records;
+    std::string ids;
+    book.forEachOrder([&](const auto& order) {
+        SnapshotRecord r{};
+        r.price = order.price;
+        r.idOffset = ids.size();
+        r.idLength = static_cast<uint32_t>(order.id.size());
+        r.quantity = order.quantity;
+        r.isBuy = order.isBuy;
+        records.push_back(r);
+        ids += order.id;
+    });
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.recordSize = sizeof(SnapshotRecord);
+    header.orderCount = records.size();
+    header.recordsOffset = sizeof(SnapshotHeader);
+    header.idsOffset = header.recordsOffset + records.size() * sizeof(SnapshotRecord);
+    header.idsBytes = ids.size();
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(SnapshotRecord));
+    out.write(ids.data(), ids.size());
+    if (!out) {
+        std::cerr << "Failed to write snapshot: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Read-only memory mapping of a snapshot file. Records are read in place;
+// nothing is parsed or copied until a book restores from it.
+class SnapshotImage {
+public:
+    SnapshotImage() = default;
+    SnapshotImage(const SnapshotImage&) = delete;
+    SnapshotImage& operator=(const SnapshotImage&) = delete;
+    ~SnapshotImage() { close(); }
+
+    bool open(const std::string& path) {
+        close();
+        if (!map(path)) {
+            std::cerr << "Failed to map snapshot: " << path << std::endl;
+            return false;
+        }
+        if (!validate()) {
+            std::cerr << "Not a valid snapshot: " << path << std::endl;
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (!base) return;
+#ifdef _WIN32
+        UnmapViewOfFile(base);
+        CloseHandle(mapping);
+        CloseHandle(file);
+        mapping = file = nullptr;
+#else
+        munmap(const_cast<char*>(base), bytes);
+#endif
+        base = nullptr;
+        bytes = 0;
+    }
+
+    size_t size() const { return base ? header().orderCount : 0; }
+
+    const SnapshotRecord& record(size_t i) const {
+        return reinterpret_cast<const SnapshotRecord*>(base + header().recordsOffset)[i];
+    }
+
+    std::string_view id(size_t i) const {
+        const SnapshotRecord& r = record(i);
+        return std::string_view(base + header().idsOffset + r.idOffset, r.idLength);
+    }
+
+private:
+    const char* base = nullptr;
+    size_t bytes = 0;
+#ifdef _WIN32
+    HANDLE file = nullptr;
+    HANDLE mapping = nullptr;
+#endif
+
+    const SnapshotHeader& header() const {
+        return *reinterpret_cast<const SnapshotHeader*>(base);
+    }
+
+    bool map(const std::string& path) {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            file = nullptr;
+            return false;
+        }
+        LARGE_INTEGER fileSize;
+        GetFileSizeEx(file, &fileSize);
+        bytes = static_cast<size_t>(fileSize.QuadPart);
+        mapping = bytes ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+        base = mapping ? static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+        if (!base) {
+            if (mapping) CloseHandle(mapping);
+            CloseHandle(file);
+            mapping = file = nullptr;
+            return false;
+        }
+        return true;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+        bytes = static_cast<size_t>(st.st_size);
+        void* p = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return false;
+        base = static_cast<const char*>(p);
+        return true;
+#endif
+    }
+
+    bool validate() const {
+        if (bytes < sizeof(SnapshotHeader)) return false;
+        const SnapshotHeader& h = header();
+        return std::memcmp(h.magic, SNAPSHOT_MAGIC, sizeof(h.magic)) == 0
+            && h.version == SNAPSHOT_VERSION
+            && h.recordSize == sizeof(SnapshotRecord)
+            && h.recordsOffset + h.orderCount * sizeof(SnapshotRecord) == h.idsOffset
+            && h.idsOffset + h.idsBytes <= bytes;
+    }
+};
@@ -0,0 +1,208 @@
+#pragma once
+#include "OrderBook.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+// ================================
+// Single-writer seqlock. The writer bumps the sequence to odd, stores the
+// payload word by word, then bumps it back to even. Readers copy the words and
+// retry if the sequence was odd or changed, so they never block the writer.
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock payload must be trivially copyable");
+    static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    alignas(64) std::atomic<uint64_t> seq{0};
+    std::atomic<uint64_t> words[WORDS];
+
+public:
+    SeqLock() {
+        for (auto& w : words) w.store(0, std::memory_order_relaxed);
+    }
+
+    // Writer side only.
+    void store(const T& value) {
+        uint64_t buf[WORDS] = {};
+        std::memcpy(buf, &value, sizeof(T));
+
+        uint64_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; i++) {
+            words[i].store(buf[i], std::memory_order_relaxed);
+        }
+        seq.store(s + 2, std::memory_order_release);
+    }
+
+    // Single attempt; returns false if a write was in progress or happened
+    // during the copy.
+    bool tryLoad(T& out) const {
+        uint64_t s0 = seq.load(std::memory_order_acquire);
+        if (s0 & 1) return false;
+
+        uint64_t buf[WORDS];
+        for (size_t i = 0; i < WORDS; i++) {
+            buf[i] = words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq.load(std::memory_order_relaxed) != s0) return false;
+
+        std::memcpy(&out, buf, sizeof(T));
+        return true;
+    }
+
+    // Spins until a consistent copy is obtained; returns the number of retries.
+    size_t load(T& out) const {
+        size_t retries = 0;
+        while (!tryLoad(out)) retries++;
+        return retries;
+    }
+};
+
+
+// What a reader (risk, UI) sees of one shard: always a state that existed
+// between two writer operations.
+struct ShardSnapshot {
+    static constexpr size_t DEPTH = 5;
+
+    uint64_t version;       // number of writer operations published
+    int orderCount;
+    size_t bidLevels;
+    size_t askLevels;
+    size_t bidDepth;
+    size_t askDepth;
+    PriceLevelInfo bids[DEPTH];
+    PriceLevelInfo asks[DEPTH];
+};
+
+
+// ================================
+// OptimizedOrderBook split into shards by order id. Each shard must be mutated
+// by exactly one writer thread; any number of threads may call snapshot().
+class ShardedOrderBook {
+public:
+    class alignas(64) Shard {
+    public:
+        explicit Shard(size_t reserveSize) : book(reserveSize) {
+            publish();
+        }
+
+        // ---- writer thread only ----
+        void addOrder(const std::string& id, double price, int quantity, bool isBuy) {
+            book.addOrder(id, price, quantity, isBuy);
+            publish();
+        }
+
+        void modifyOrder(const std::string& id, double newPrice, int newQuantity) {
+            book.modifyOrder(id, newPrice, newQuantity);
+            publish();
+        }
+
+        void deleteOrder(const std::string& id) {
+            book.deleteOrder(id);
+            publish();
+        }
+
+        bool findOrder(const std::string& id) const {
+            return book.findOrder(id);
+        }
+
+        // ---- any thread ----
+        size_t snapshot(ShardSnapshot& out) const {
+            return published.load(out);
+        }
+
+    private:
+        OptimizedOrderBook book;
+        SeqLock<ShardSnapshot> published;
+        uint64_t version = 0;
+
+        void publish() {
+            ShardSnapshot snap{};
+            snap.version = ++version;
+            snap.orderCount = book.getOrderCount();
+            snap.bidLevels = book.levelCount(true);
+            snap.askLevels = book.levelCount(false);
+            snap.bidDepth = book.getDepth(true, snap.bids, ShardSnapshot::DEPTH);
+            snap.askDepth = book.getDepth(false, snap.asks, ShardSnapshot::DEPTH);
+            published.store(snap);
+        }
+    };
+
+    ShardedOrderBook(size_t numShards, size_t reservePerShard = 100000) {
+        shards.reserve(numShards);
+        for (size_t i = 0; i < numShards; i++) {
+            shards.emplace_back(new Shard(reservePerShard));
+        }
+    }
+
+    size_t shardCount() const {
+        return shards.size();
+    }
+
+    size_t shardFor(const std::string& id) const {
+        return std::hash<std::string>{}(id) % shards.size();
+    }
+
+    Shard& shard(size_t i) {
+        return *shards[i];
+    }
+
+    const Shard& shard(size_t i) const {
+        return *shards[i];
+    }
+
+    // Routing helpers for single-threaded callers. With several writer
+    // threads, each thread must only touch ids for which shardFor() is its own.
+    void addOrder(const std::string& id, double price, int quantity, bool isBuy) {
+        shard(shardFor(id)).addOrder(id, price, quantity, isBuy);
+    }
+
+    void modifyOrder(const std::string& id, double newPrice, int newQuantity) {
+        shard(shardFor(id)).modifyOrder(id, newPrice, newQuantity);
+    }
+
+    void deleteOrder(const std::string& id) {
+        shard(shardFor(id)).deleteOrder(id);
+    }
+
+    bool findOrder(const std::string& id) const {
+        return shard(shardFor(id)).findOrder(id);
+    }
+
+    // Reader view of the whole book: best bid/ask merged across shards. Each
+    // shard's contribution is consistent; shards are sampled one after another.
+    // Returns the total number of seqlock retries.
+    size_t topOfBook(PriceLevelInfo& bestBid, PriceLevelInfo& bestAsk, bool& hasBid, bool& hasAsk) const {
+        size_t retries = 0;
+        hasBid = hasAsk = false;
+        ShardSnapshot snap;
+        for (const auto& s : shards) {
+            retries += s->snapshot(snap);
+            if (snap.bidDepth) mergeLevel(bestBid, hasBid, snap.bids[0], true);
+            if (snap.askDepth) mergeLevel(bestAsk, hasAsk, snap.asks[0], false);
+        }
+        return retries;
+    }
+
+private:
+    std::vector<std::unique_ptr<Shard>> shards;
+
+    static void mergeLevel(PriceLevelInfo& best, bool& has, const PriceLevelInfo& level, bool isBuy) {
+        if (!has || (isBuy ? level.price > best.price : level.price < best.price)) {
+            best = level;
+            has = true;
+        }
+        else if (level.price == best.price) {
+            best.totalQuantity += level.totalQuantity;
+            best.orderCount += level.orderCount;
+        }
+    }
+};
@@ -0,0 +1,158 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define ORDERBOOK_X86_SIMD 1
+#endif
+
+
+// Notional and volume split by side over a set of orders.
+struct ExposureSummary {
+    double buyNotional;
+    double sellNotional;
+    long long buyQuantity;
+    long long sellQuantity;
+
+    double notional() const { return buyNotional + sellNotional; }
+    double netExposure() const { return buyNotional - sellNotional; }
+
+    // Volume-weighted price over both sides; 0 if there is no volume.
+    double vwap() const {
+        long long q = buyQuantity + sellQuantity;
+        return q ? notional() / q : 0.0;
+    }
+    double buyVwap() const { return buyQuantity ? buyNotional / buyQuantity : 0.0; }
+    double sellVwap() const { return sellQuantity ? sellNotional / sellQuantity : 0.0; }
+};
+
+// Kernels over structure-of-arrays columns: price[i], quantity[i] and
+// isBuy[i] (0 or 1) describe order i.
+namespace simd {
+
+using ExposureKernel = ExposureSummary (*)(const double*, const int*, const uint8_t*, size_t);
+
+inline ExposureSummary exposureScalar(const double* price, const int* quantity, const uint8_t* isBuy, size_t n) {
+    ExposureSummary r{0.0, 0.0, 0, 0};
+    double totalNotional = 0.0;
+    long long totalQuantity = 0;
+    for (size_t i = 0; i < n; i++) {
+        double notional = price[i] * quantity[i];
+        totalNotional += notional;
+        totalQuantity += quantity[i];
+        if (isBuy[i]) {
+            r.buyNotional += notional;
+            r.buyQuantity += quantity[i];
+        }
+    }
+    r.sellNotional = totalNotional - r.buyNotional;
+    r.sellQuantity = totalQuantity - r.buyQuantity;
+    return r;
+}
+
+#ifdef ORDERBOOK_X86_SIMD
+
+// Sides are widened to 0.0/1.0 and multiplied in, so the buy sums need no
+// branches or masks; sell sums are total minus buy.
+__attribute__((target("avx2,fma")))
+inline ExposureSummary exposureAvx2(const double* price, const int* quantity, const uint8_t* isBuy, size_t n) {
+    __m256d buyNotional = _mm256_setzero_pd(), totalNotional = _mm256_setzero_pd();
+    __m256d buyQuantity = _mm256_setzero_pd(), totalQuantity = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        int32_t sides;
+        std::memcpy(&sides, isBuy + i, sizeof(sides));
+        __m256d p = _mm256_loadu_pd(price + i);
+        __m256d q = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(quantity + i)));
+        __m256d b = _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(sides)));
+        __m256d notional = _mm256_mul_pd(p, q);
+        totalNotional = _mm256_add_pd(totalNotional, notional);
+        buyNotional = _mm256_fmadd_pd(notional, b, buyNotional);
+        totalQuantity = _mm256_add_pd(totalQuantity, q);
+        buyQuantity = _mm256_fmadd_pd(q, b, buyQuantity);
+    }
+
+    alignas(32) double lanes[4][4];
+    _mm256_store_pd(lanes[0], buyNotional);
+    _mm256_store_pd(lanes[1], totalNotional);
+    _mm256_store_pd(lanes[2], buyQuantity);
+    _mm256_store_pd(lanes[3], totalQuantity);
+    double sums[4];
+    for (int k = 0; k < 4; k++) sums[k] = (lanes[k][0] + lanes[k][1]) + (lanes[k][2] + lanes[k][3]);
+
+    ExposureSummary tail = exposureScalar(price + i, quantity + i, isBuy + i, n - i);
+    ExposureSummary r;
+    r.buyNotional = sums[0] + tail.buyNotional;
+    r.sellNotional = sums[1] - sums[0] + tail.sellNotional;
+    r.buyQuantity = (long long)sums[2] + tail.buyQuantity;
+    r.sellQuantity = (long long)(sums[3] - sums[2]) + tail.sellQuantity;
+    return r;
+}
+
+__attribute__((target("avx512f,avx2")))
+inline ExposureSummary exposureAvx512(const double* price, const int* quantity, const uint8_t* isBuy, size_t n) {
+    __m512d buyNotional = _mm512_setzero_pd(), totalNotional = _mm512_setzero_pd();
+    __m512d buyQuantity = _mm512_setzero_pd(), totalQuantity = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d p = _mm512_loadu_pd(price + i);
+        // maskz forms: same instruction, but GCC's plain wrappers trip -Wmaybe-uninitialized
+        __m512d q = _mm512_maskz_cvtepi32_pd(0xFF, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(quantity + i)));
+        __m512d b = _mm512_maskz_cvtepi32_pd(0xFF, _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(isBuy + i))));
+        __m512d notional = _mm512_mul_pd(p, q);
+        totalNotional = _mm512_add_pd(totalNotional, notional);
+        buyNotional = _mm512_fmadd_pd(notional, b, buyNotional);
+        totalQuantity = _mm512_add_pd(totalQuantity, q);
+        buyQuantity = _mm512_fmadd_pd(q, b, buyQuantity);
+    }
+
+    alignas(64) double lanes[4][8];
+    _mm512_store_pd(lanes[0], buyNotional);
+    _mm512_store_pd(lanes[1], totalNotional);
+    _mm512_store_pd(lanes[2], buyQuantity);
+    _mm512_store_pd(lanes[3], totalQuantity);
+    double sums[4];
+    for (int k = 0; k < 4; k++) {
+        sums[k] = ((lanes[k][0] + lanes[k][1]) + (lanes[k][2] + lanes[k][3]))
+                + ((lanes[k][4] + lanes[k][5]) + (lanes[k][6] + lanes[k][7]));
+    }
+    double bn = sums[0], tn = sums[1], bq = sums[2], tq = sums[3];
+
+    ExposureSummary tail = exposureScalar(price + i, quantity + i, isBuy + i, n - i);
+    ExposureSummary r;
+    r.buyNotional = bn + tail.buyNotional;
+    r.sellNotional = tn - bn + tail.sellNotional;
+    r.buyQuantity = (long long)bq + tail.buyQuantity;
+    r.sellQuantity = (long long)(tq - bq) + tail.sellQuantity;
+    return r;
+}
+
+#endif
+
+// Picks the widest kernel this CPU supports; the scalar kernel everywhere else
+// (including non-x86 builds).
+inline ExposureKernel selectExposureKernel(const char** name = nullptr) {
+#ifdef ORDERBOOK_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        if (name) *name = "avx512";
+        return exposureAvx512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        if (name) *name = "avx2";
+        return exposureAvx2;
+    }
+#endif
+    if (name) *name = "scalar";
+    return exposureScalar;
+}
+
+// Resolved once on first use.
+inline ExposureSummary exposure(const double* price, const int* quantity, const uint8_t* isBuy, size_t n) {
+    static const ExposureKernel kernel = selectExposureKernel();
+    return kernel(price, quantity, isBuy, n);
+}
+
+}  // namespace simd
@@ -1,214 +1,634 @@
+#include "AllocationCounter.hpp"
 #include "OrderBook.hpp"
+#include "CompactOrderBook.hpp"
+#include "ShardedOrderBook.hpp"
 #include <vector>
 #include <random>
 #include <algorithm>
 #include <iostream>
 #include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
 #include <fstream>
+#include <memory>
+#include <thread>
+
+using bench_clock = std::chrono::steady_clock;
+
+// ================= CSV schema =================
+// Bump CSV_SCHEMA_VERSION whenever columns change. Rows of different versions
+// never share a file: an existing file with another header is moved aside to
+// benchmark_results.v<old>.csv before the new header is written.
+const int CSV_SCHEMA_VERSION = 2;
+const char* CSV_HEADER =
+    "SchemaVersion,TestType,Operation,NumOrders,NumOps,Repetitions,"
+    "MedianSec,MinSec,MaxSec,StdDevSec,MadSec,OpsPerSec,"
+    "P50Ns,P90Ns,P99Ns,P999Ns,MaxNs";
+
+struct BenchmarkConfig {
+    int warmupRuns = 1;
+    int repetitions = 5;
+};
 
+// One row of the CSV: a timed operation over all repetitions.
 struct BenchmarkResult {
+    std::string testType;
+    std::string operation;
     int numOrders;
-    double insertTime;
-    double modifyTime;
-    double deleteTime;
-    double totalTime;
+    int numOps;
+    int repetitions;
+    double medianSec, minSec, maxSec, stdDevSec, madSec;
+    double opsPerSec;
+    double p50Ns, p90Ns, p99Ns, p999Ns, maxNs;
 };
 
 void writeCSVHeader(const std::string& filename) {
-    std::ofstream file(filename, std::ios::app);
-    if (file.tellp() == 0) {
-        file << "TestType,NumOrders,NumLookups,Insert,Modify,Delete,Total,LookupTime\n";
+    std::string firstLine, secondLine;
+    {
+        std::ifstream in(filename);
+        std::getline(in, firstLine);
+        std::getline(in, secondLine);
+    }
+    if (!firstLine.empty() && firstLine != CSV_HEADER) {
+        // v1 had no SchemaVersion column
+        int oldVersion = firstLine.rfind("SchemaVersion,", 0) == 0 ? std::atoi(secondLine.c_str()) : 1;
+        std::string archived = filename.substr(0, filename.rfind('.')) + ".v" + std::to_string(oldVersion) + ".csv";
+        std::rename(filename.c_str(), archived.c_str());
+        std::cout << "Existing " << filename << " has another schema, moved to " << archived << "\n";
+        firstLine.clear();
+    }
+    if (firstLine.empty()) {
+        std::ofstream file(filename, std::ios::trunc);
+        file << CSV_HEADER << "\n";
     }
 }
 
-void appendToCSV(const std::string& filename, const std::string& testType, const BenchmarkResult& result, int numLookups = 0, double lookupTime = 0.0) {
+void appendToCSV(const std::string& filename, const BenchmarkResult& r) {
     std::ofstream file(filename, std::ios::app);
-    file << testType << "," << result.numOrders << "," << numLookups << ","
-         << result.insertTime << "," << result.modifyTime << ","
-         << result.deleteTime << "," << result.totalTime << "," << lookupTime << "\n";
+    file << CSV_SCHEMA_VERSION << "," << r.testType << "," << r.operation << ","
+         << r.numOrders << "," << r.numOps << "," << r.repetitions << ","
+         << r.medianSec << "," << r.minSec << "," << r.maxSec << ","
+         << r.stdDevSec << "," << r.madSec << "," << r.opsPerSec << ","
+         << r.p50Ns << "," << r.p90Ns << "," << r.p99Ns << ","
+         << r.p999Ns << "," << r.maxNs << "\n";
+}
+
+// ================= Statistics =================
+double percentile(const std::vector<double>& sorted, double q) {
+    if (sorted.empty()) return 0.0;
+    size_t i = static_cast<size_t>(q * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(i, sorted.size() - 1)];
+}
+
+// Fills the repetition statistics (seconds) and, if per-op latencies were
+// recorded, the latency percentiles (nanoseconds).
+BenchmarkResult summarize(const std::string& testType, const std::string& operation, int numOrders, int numOps,
+                          std::vector<double> seconds, std::vector<double> latenciesNs) {
+    BenchmarkResult r{};
+    r.testType = testType;
+    r.operation = operation;
+    r.numOrders = numOrders;
+    r.numOps = numOps;
+    r.repetitions = (int)seconds.size();
+    std::sort(seconds.begin(), seconds.end());
+    r.medianSec = percentile(seconds, 0.5);
+    r.minSec = seconds.front();
+    r.maxSec = seconds.back();
+
+    double mean = 0.0;
+    for (double s : seconds) mean += s;
+    mean /= seconds.size();
+    double var = 0.0;
+    for (double s : seconds) var += (s - mean) * (s - mean);
+    r.stdDevSec = seconds.size() > 1 ? std::sqrt(var / (seconds.size() - 1)) : 0.0;
+
+    std::vector<double> deviations;
+    for (double s : seconds) deviations.push_back(std::fabs(s - r.medianSec));
+    std::sort(deviations.begin(), deviations.end());
+    r.madSec = percentile(deviations, 0.5);
+    r.opsPerSec = r.medianSec > 0 ? numOps / r.medianSec : 0.0;
+
+    std::sort(latenciesNs.begin(), latenciesNs.end());
+    r.p50Ns = percentile(latenciesNs, 0.5);
+    r.p90Ns = percentile(latenciesNs, 0.9);
+    r.p99Ns = percentile(latenciesNs, 0.99);
+    r.p999Ns = percentile(latenciesNs, 0.999);
+    r.maxNs = latenciesNs.empty() ? 0.0 : latenciesNs.back();
+    return r;
+}
+
+void report(const std::string& csvFile, const BenchmarkResult& r) {
+    std::printf("%-20s %-17s N=%-7d ops=%-7d median=%.6fs mad=%.6fs %8.2f Mops/s p50=%.0fns p99=%.0fns p99.9=%.0fns\n",
+                r.testType.c_str(), r.operation.c_str(), r.numOrders, r.numOps, r.medianSec, r.madSec,
+                r.opsPerSec / 1e6, r.p50Ns, r.p99Ns, r.p999Ns);
+    appendToCSV(csvFile, r);
+}
+
+double elapsedSec(bench_clock::time_point a, bench_clock::time_point b) {
+    return std::chrono::duration<double>(b - a).count();
+}
+
+double elapsedNs(bench_clock::time_point a, bench_clock::time_point b) {
+    return std::chrono::duration<double, std::nano>(b - a).count();
+}
+
+// Median cost of one back-to-back clock read pair; included in every per-op
+// latency sample.
+double clockOverheadNs() {
+    std::vector<double> v(100000);
+    for (auto& x : v) {
+        auto a = bench_clock::now();
+        auto b = bench_clock::now();
+        x = elapsedNs(a, b);
+    }
+    std::sort(v.begin(), v.end());
+    return percentile(v, 0.5);
 }
 
-BenchmarkResult benchmark_baseline(const int NUM_ORDERS) {
-    OrderBook ob;
-    std::vector<std::string> orderIds;
-    orderIds.reserve(NUM_ORDERS);
+// ================= Pre-generated workload =================
+// Everything a run needs is generated up front so timed loops do no string
+// formatting or RNG work, and every book replays the identical stream.
+struct Workload {
+    std::vector<std::string> ids;
+    std::vector<double> prices;
+    std::vector<int> quantities;
+    std::vector<char> isBuy;
 
+    std::vector<size_t> modifyIdx;
+    std::vector<double> modifyPrices;
+    std::vector<int> modifyQuantities;
+
+    std::vector<size_t> deleteIdx;
+};
+
+Workload makeWorkload(int numOrders) {
+    Workload w;
     std::mt19937 rng(42);
     std::uniform_real_distribution<double> priceDist(50.0, 150.0);
     std::uniform_int_distribution<int> qtyDist(1, 1000);
 
-    auto tic = std::chrono::high_resolution_clock::now();
-
-    auto startInsert = std::chrono::high_resolution_clock::now();
-    for(int i = 0; i < NUM_ORDERS; i++) {
-        std::string id = "ORD" + std::to_string(i);
-        double price = priceDist(rng);
-        int qty = qtyDist(rng);
-        bool isBuy = (i % 2 == 0);
-        ob.addOrder(id, price, qty, isBuy);
-        orderIds.push_back(id);
+    for (int i = 0; i < numOrders; i++) {
+        w.ids.push_back("OID" + std::to_string(i));
+        w.prices.push_back(priceDist(rng));
+        w.quantities.push_back(qtyDist(rng));
+        w.isBuy.push_back(i % 2 == 0);
     }
-    auto endInsert = std::chrono::high_resolution_clock::now();
 
-    std::shuffle(orderIds.begin(), orderIds.end(), rng);
+    std::vector<size_t> order(numOrders);
+    for (int i = 0; i < numOrders; i++) order[i] = i;
+    std::shuffle(order.begin(), order.end(), rng);
 
-    auto startModify = std::chrono::high_resolution_clock::now();
-    for(int i = 0; i < NUM_ORDERS / 2; i++) {
-        double newPrice = priceDist(rng);
-        int newQty = qtyDist(rng);
-        ob.modifyOrder(orderIds[i], newPrice, newQty);
+    for (int i = 0; i < numOrders / 2; i++) {
+        w.modifyIdx.push_back(order[i]);
+        w.modifyPrices.push_back(priceDist(rng));
+        w.modifyQuantities.push_back(qtyDist(rng));
     }
-    auto endModify = std::chrono::high_resolution_clock::now();
-
-    auto startDelete = std::chrono::high_resolution_clock::now();
-    for(int i = 0; i < NUM_ORDERS / 4; i++) {
-        ob.deleteOrder(orderIds[i]);
+    for (int i = 0; i < numOrders / 4; i++) {
+        w.deleteIdx.push_back(order[i]);
     }
-    auto endDelete = std::chrono::high_resolution_clock::now();
+    return w;
+}
 
-    auto toc = std::chrono::high_resolution_clock::now();
+std::vector<size_t> makeLookups(int numOrders, int numLookups, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> idDist(0, numOrders - 1);
+    std::vector<size_t> lookups(numLookups);
+    for (auto& i : lookups) i = idDist(rng);
+    return lookups;
+}
 
-    std::chrono::duration<double> insertTime = endInsert - startInsert;
-    std::chrono::duration<double> modifyTime = endModify - startModify;
-    std::chrono::duration<double> deleteTime = endDelete - startDelete;
-    std::chrono::duration<double> totalTime = toc - tic;
+template <typename Book>
+void loadBook(Book& book, const Workload& w) {
+    for (size_t i = 0; i < w.ids.size(); i++) {
+        book.addOrder(w.ids[i], w.prices[i], w.quantities[i], w.isBuy[i]);
+    }
+}
 
-    std::cout << "======== Benchmark Result ========\n";
-    std::cout << "Insert: " << insertTime.count() << " s\n";
-    std::cout << "Modify: " << modifyTime.count() << " s\n";
-    std::cout << "Delete: " << deleteTime.count() << " s\n";
-    std::cout << "Total:  " << totalTime.count() << " s\n";
+// ================= Insert / Modify / Delete =================
+// One pass over the workload on a fresh book. With latencies == nullptr each
+// phase is timed as a whole; otherwise every operation is timed individually.
+template <typename MakeBook>
+void runBookPass(MakeBook makeBook, const Workload& w, double phaseSec[3], std::vector<double>* latencies) {
+    auto book = makeBook();
+    const size_t n = w.ids.size();
+
+    auto t0 = bench_clock::now();
+    for (size_t i = 0; i < n; i++) {
+        auto a = latencies ? bench_clock::now() : bench_clock::time_point{};
+        book->addOrder(w.ids[i], w.prices[i], w.quantities[i], w.isBuy[i]);
+        if (latencies) latencies[0].push_back(elapsedNs(a, bench_clock::now()));
+    }
+    auto t1 = bench_clock::now();
+    for (size_t i = 0; i < w.modifyIdx.size(); i++) {
+        auto a = latencies ? bench_clock::now() : bench_clock::time_point{};
+        book->modifyOrder(w.ids[w.modifyIdx[i]], w.modifyPrices[i], w.modifyQuantities[i]);
+        if (latencies) latencies[1].push_back(elapsedNs(a, bench_clock::now()));
+    }
+    auto t2 = bench_clock::now();
+    for (size_t i = 0; i < w.deleteIdx.size(); i++) {
+        auto a = latencies ? bench_clock::now() : bench_clock::time_point{};
+        book->deleteOrder(w.ids[w.deleteIdx[i]]);
+        if (latencies) latencies[2].push_back(elapsedNs(a, bench_clock::now()));
+    }
+    auto t3 = bench_clock::now();
 
-    BenchmarkResult result{NUM_ORDERS, insertTime.count(), modifyTime.count(), deleteTime.count(), totalTime.count()};
-    return result;
+    phaseSec[0] = elapsedSec(t0, t1);
+    phaseSec[1] = elapsedSec(t1, t2);
+    phaseSec[2] = elapsedSec(t2, t3);
 }
 
-// ================= OptimizedOrderBook Benchmark =================
-BenchmarkResult benchmark_optimized(const int NUM_ORDERS) {
-    OptimizedOrderBook optOb(NUM_ORDERS);
-    std::vector<std::string> orderIds;
-    orderIds.reserve(NUM_ORDERS);
+// makeBook returns a std::unique_ptr to a fresh, empty book.
+template <typename MakeBook>
+void benchmark_book(const std::string& testType, MakeBook makeBook, const Workload& w,
+                    const BenchmarkConfig& cfg, const std::string& csvFile) {
+    double phase[3];
+    for (int r = 0; r < cfg.warmupRuns; r++) {
+        runBookPass(makeBook, w, phase, nullptr);
+    }
 
-    std::mt19937 rng(42);
-    std::uniform_real_distribution<double> priceDist(50.0, 150.0);
-    std::uniform_int_distribution<int> qtyDist(1, 1000);
+    std::vector<double> seconds[4];
+    for (int r = 0; r < cfg.repetitions; r++) {
+        runBookPass(makeBook, w, phase, nullptr);
+        for (int k = 0; k < 3; k++) seconds[k].push_back(phase[k]);
+        seconds[3].push_back(phase[0] + phase[1] + phase[2]);
+    }
 
-    auto startInsert = std::chrono::high_resolution_clock::now();
-    for (int i = 0; i < NUM_ORDERS; i++) {
-        std::string id = "OID" + std::to_string(i);
-        optOb.addOrder(id, priceDist(rng), qtyDist(rng), i % 2);
-        orderIds.push_back(id);
+    std::vector<double> latencies[3];
+    latencies[0].reserve(w.ids.size());
+    latencies[1].reserve(w.modifyIdx.size());
+    latencies[2].reserve(w.deleteIdx.size());
+    runBookPass(makeBook, w, phase, latencies);
+
+    const int numOrders = (int)w.ids.size();
+    const int opCounts[4] = {numOrders, (int)w.modifyIdx.size(), (int)w.deleteIdx.size(),
+                             numOrders + (int)w.modifyIdx.size() + (int)w.deleteIdx.size()};
+    const char* names[4] = {"Insert", "Modify", "Delete", "Total"};
+    for (int k = 0; k < 4; k++) {
+        report(csvFile, summarize(testType, names[k], numOrders, opCounts[k], seconds[k],
+                                  k < 3 ? latencies[k] : std::vector<double>{}));
     }
-    auto endInsert = std::chrono::high_resolution_clock::now();
+}
 
+// ================= Best-price queries =================
+void benchmark_bestPrice(const OptimizedOrderBook& optOb, int numOrders, const BenchmarkConfig& cfg,
+                         const std::string& csvFile) {
+    const int NUM_QUERIES = 100000;
+    PriceLevelInfo depth[10];
+    volatile long long sink = 0;
+    auto query = [&](int i) {
+        PriceLevelInfo best{};
+        if (i % 2 == 0) optOb.getBestBid(best);
+        else optOb.getBestAsk(best);
+        sink += best.totalQuantity + optOb.getDepth(i % 2 == 0, depth, 10);
+    };
+
+    std::vector<double> seconds, latencies;
+    for (int r = 0; r < cfg.warmupRuns + cfg.repetitions; r++) {
+        auto a = bench_clock::now();
+        for (int i = 0; i < NUM_QUERIES; i++) query(i);
+        if (r >= cfg.warmupRuns) seconds.push_back(elapsedSec(a, bench_clock::now()));
+    }
+    latencies.reserve(NUM_QUERIES);
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        auto a = bench_clock::now();
+        query(i);
+        latencies.push_back(elapsedNs(a, bench_clock::now()));
+    }
+    report(csvFile, summarize("OptimizedOrderBook", "BestDepth10", numOrders, NUM_QUERIES, seconds, latencies));
+}
 
-    std::shuffle(orderIds.begin(), orderIds.end(), rng);
-    auto startModify = std::chrono::high_resolution_clock::now();
-    for (int i = 0; i < NUM_ORDERS / 2; i++) {
-        double newPrice = priceDist(rng);
-        int newQty = qtyDist(rng);
-        optOb.modifyOrder(orderIds[i], newPrice, newQty);
+// ================= Exposure aggregation =================
+// Book-level: computeExposure() on a row book (walks Order structs) and on a
+// columnar book (dispatched SIMD kernel). Kernel-level: each kernel this CPU
+// can run, over the same columns.
+void benchmark_exposure(const Workload& w, const BenchmarkConfig& cfg, const std::string& csvFile) {
+    const int numOrders = (int)w.ids.size();
+    volatile double sink = 0.0;
+    auto timeIt = [&](const std::string& operation, auto fn) {
+        std::vector<double> seconds;
+        for (int r = 0; r < cfg.warmupRuns + cfg.repetitions; r++) {
+            auto a = bench_clock::now();
+            sink = sink + fn().notional();
+            if (r >= cfg.warmupRuns) seconds.push_back(elapsedSec(a, bench_clock::now()));
+        }
+        report(csvFile, summarize("OptimizedOrderBook", operation, numOrders, numOrders, seconds, {}));
+    };
+
+    OptimizedOrderBook rows(numOrders);
+    OptimizedOrderBook columns(numOrders, OptimizedOrderBook::StorageMode::Columnar);
+    loadBook(rows, w);
+    loadBook(columns, w);
+    timeIt("Exposure_Rows", [&] { return rows.computeExposure(); });
+    timeIt("Exposure_Columnar", [&] { return columns.computeExposure(); });
+
+    std::vector<uint8_t> isBuy(w.isBuy.begin(), w.isBuy.end());
+    const double* p = w.prices.data();
+    const int* q = w.quantities.data();
+    const uint8_t* b = isBuy.data();
+    timeIt("Kernel_scalar", [&] { return simd::exposureScalar(p, q, b, numOrders); });
+#ifdef ORDERBOOK_X86_SIMD
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        timeIt("Kernel_avx2", [&] { return simd::exposureAvx2(p, q, b, numOrders); });
     }
-    auto endModify =  std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> modifyTime = endModify - startModify;
+    if (__builtin_cpu_supports("avx512f")) {
+        timeIt("Kernel_avx512", [&] { return simd::exposureAvx512(p, q, b, numOrders); });
+    }
+#endif
+}
 
-    auto startDelete = std::chrono::high_resolution_clock::now();
-    for (int i = 0; i < NUM_ORDERS / 4; i++) {
-        optOb.deleteOrder(orderIds[i]);
+// ================= Snapshot restore =================
+// Restart cost: replaying addOrder for every order versus mapping a snapshot
+// image and restoring from it. For OptimizedOrderBook the deferred index build is
+// reported separately (Restore_Index), since a restored book can already be
+// iterated and aggregated before it runs.
+void benchmark_restore(const Workload& w, const BenchmarkConfig& cfg, const std::string& csvFile) {
+    const int numOrders = (int)w.ids.size();
+    const std::string path = "snapshot_bench.bin";
+    auto timeRuns = [&](const std::string& testType, const std::string& operation, auto prepare, auto fn) {
+        std::vector<double> seconds;
+        for (int r = 0; r < cfg.warmupRuns + cfg.repetitions; r++) {
+            auto state = prepare();
+            auto a = bench_clock::now();
+            fn(*state);
+            if (r >= cfg.warmupRuns) seconds.push_back(elapsedSec(a, bench_clock::now()));
+        }
+        report(csvFile, summarize(testType, operation, numOrders, numOrders, seconds, {}));
+    };
+
+    {
+        OptimizedOrderBook source(numOrders);
+        loadBook(source, w);
+        saveSnapshot(source, path);
+        auto fresh = [&] { return std::make_unique<OptimizedOrderBook>(numOrders); };
+        timeRuns("OptimizedOrderBook", "Rebuild_addOrder", fresh, [&](OptimizedOrderBook& b) { loadBook(b, w); });
+        timeRuns("OptimizedOrderBook", "Restore_Mmap", fresh, [&](OptimizedOrderBook& b) {
+            SnapshotImage image;
+            image.open(path);
+            b.restoreFrom(image);
+        });
+        timeRuns("OptimizedOrderBook", "Restore_Index",
+                 [&] {
+                     auto b = fresh();
+                     SnapshotImage image;
+                     image.open(path);
+                     b->restoreFrom(image);
+                     return b;
+                 },
+                 [&](OptimizedOrderBook& b) { b.ensureIndex(); });
+    }
+    {
+        OrderBook source;
+        loadBook(source, w);
+        saveSnapshot(source, path);
+        auto fresh = [] { return std::make_unique<OrderBook>(); };
+        timeRuns("OrderBook", "Rebuild_addOrder", fresh, [&](OrderBook& b) { loadBook(b, w); });
+        timeRuns("OrderBook", "Restore_Mmap", fresh, [&](OrderBook& b) {
+            SnapshotImage image;
+            image.open(path);
+            b.restoreFrom(image);
+        });
     }
-    auto endDelete = std::chrono::high_resolution_clock::now();
+    std::remove(path.c_str());
+}
 
-    std::chrono::duration<double> insertTime = endInsert - startInsert;
-    std::chrono::duration<double> deleteTime = endDelete - startDelete;
-    BenchmarkResult result{NUM_ORDERS, insertTime.count(), modifyTime.count(), deleteTime.count(), insertTime.count() + modifyTime.count() + deleteTime.count()};
-    std::cout << "Optimized Insert: " << insertTime.count() << " s\n";
-    std::cout << "Optimized Modify: " << modifyTime.count() << " s\n";
-    std::cout << "Optimized Delete: " << deleteTime.count() << " s\n";
+// ================= Bulk load =================
+// Start-of-day load into an empty book: addOrder per order versus one
+// addOrders call. Books are default-constructed so the per-order loop pays
+// its own growth, as it would at the open.
+void benchmark_bulkLoad(int numOrders, const BenchmarkConfig& cfg, const std::string& csvFile) {
+    Workload w = makeWorkload(numOrders);
+    std::vector<Order> orders;
+    orders.reserve(numOrders);
+    for (int i = 0; i < numOrders; i++) {
+        orders.push_back(Order{w.ids[i], w.prices[i], w.quantities[i], w.isBuy[i] != 0});
+    }
 
-    return result;
+    auto timeRuns = [&](const std::string& testType, const std::string& operation, auto makeBook, auto fn) {
+        std::vector<double> seconds;
+        for (int r = 0; r < cfg.warmupRuns + cfg.repetitions; r++) {
+            auto book = makeBook();
+            auto a = bench_clock::now();
+            fn(*book);
+            if (r >= cfg.warmupRuns) seconds.push_back(elapsedSec(a, bench_clock::now()));
+        }
+        report(csvFile, summarize(testType, operation, numOrders, numOrders, seconds, {}));
+    };
+
+    auto optimized = [] { return std::make_unique<OptimizedOrderBook>(); };
+    timeRuns("OptimizedOrderBook", "Load_addOrder", optimized, [&](OptimizedOrderBook& b) { loadBook(b, w); });
+    timeRuns("OptimizedOrderBook", "Load_addOrders", optimized, [&](OptimizedOrderBook& b) { b.addOrders(orders); });
+
+    auto plain = [] { return std::make_unique<OrderBook>(); };
+    timeRuns("OrderBook", "Load_addOrder", plain, [&](OrderBook& b) { loadBook(b, w); });
+    timeRuns("OrderBook", "Load_addOrders", plain, [&](OrderBook& b) { b.addOrders(orders); });
+}
+
+// ================= Memory per order =================
+// Heap bytes held by a loaded book (AllocationCounter.hpp), divided by its
+// order count. Prices are rounded to a 0.01 tick so the level maps are the
+// size of a real book rather than one level per order.
+void benchmark_memory(int numOrders, const std::string& memFile) {
+    Workload w = makeWorkload(numOrders);
+    for (double& price : w.prices) price = std::round(price * 100.0) / 100.0;
+
+    auto measure = [&](const std::string& testType, auto makeBook) {
+        long long before = memstats::liveBytes();
+        auto a = bench_clock::now();
+        auto book = makeBook();
+        loadBook(*book, w);
+        double loadSec = elapsedSec(a, bench_clock::now());
+        long long bytes = memstats::liveBytes() - before;
+        double perOrder = (double)bytes / numOrders;
+        std::printf("%-20s Memory            N=%-7d bytes=%-11lld %7.1f B/order  load=%.3fs\n",
+                    testType.c_str(), numOrders, bytes, perOrder, loadSec);
+        std::ofstream file(memFile, std::ios::app);
+        file << testType << "," << numOrders << "," << bytes << "," << perOrder << "," << loadSec << "\n";
+    };
+
+    measure("OrderBook", [] { return std::make_unique<OrderBook>(); });
+    measure("OptimizedOrderBook", [&] { return std::make_unique<OptimizedOrderBook>(numOrders); });
+    measure("OptimizedOrderBook_Col", [&] {
+        return std::make_unique<OptimizedOrderBook>(numOrders, OptimizedOrderBook::StorageMode::Columnar);
+    });
+    measure("CompactOrderBook", [&] { return std::make_unique<CompactOrderBook>(numOrders); });
 }
 
 // ================= Lookup Benchmark =================
-double lookupBenchmark_OrderBook(int numOrders, int numLookups) {
-    OrderBook ob;
-    std::vector<std::string> orderIds;
-    orderIds.reserve(numOrders);
+template <typename Book>
+BenchmarkResult lookupBenchmark(const std::string& testType, const Book& book, const Workload& w,
+                                const std::vector<size_t>& lookups, const BenchmarkConfig& cfg) {
+    auto pass = [&](std::vector<double>* latencies) {
+        size_t found = 0;
+        for (size_t idx : lookups) {
+            auto a = latencies ? bench_clock::now() : bench_clock::time_point{};
+            found += book.findOrder(w.ids[idx]);
+            if (latencies) latencies->push_back(elapsedNs(a, bench_clock::now()));
+        }
+        assert(found == lookups.size());
+        (void)found;
+    };
 
-    std::mt19937 rng(42);
-    std::uniform_real_distribution<double> priceDist(50.0, 150.0);
-    std::uniform_int_distribution<int> qtyDist(1, 1000);
-    for (int i = 0; i < numOrders; i++) {
-        std::string id = "ID" + std::to_string(i);
-        ob.addOrder(id, priceDist(rng), qtyDist(rng), i % 2);
-        orderIds.push_back(id);
+    std::vector<double> seconds, latencies;
+    for (int r = 0; r < cfg.warmupRuns + cfg.repetitions; r++) {
+        auto a = bench_clock::now();
+        pass(nullptr);
+        if (r >= cfg.warmupRuns) seconds.push_back(elapsedSec(a, bench_clock::now()));
     }
+    latencies.reserve(lookups.size());
+    pass(&latencies);
+    return summarize(testType, "Lookup", (int)w.ids.size(), (int)lookups.size(), seconds, latencies);
+}
 
-    std::mt19937 rng2(666);
-    std::uniform_int_distribution<int> idDist(0, numOrders - 1);
+BenchmarkResult lookupBenchmark_OrderBook(const OrderBook& ob, const Workload& w,
+                                          const std::vector<size_t>& lookups, const BenchmarkConfig& cfg) {
+    return lookupBenchmark("OrderBook", ob, w, lookups, cfg);
+}
 
-    auto startLookup = std::chrono::high_resolution_clock::now();
-    for (int i = 0; i < numLookups; ++i) {
-        const std::string& id = orderIds[idDist(rng2)];
-        auto found = ob.findOrder(id);
-        (void)found;
-    }
-    auto endLookup = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> lookupTime = endLookup - startLookup;
+BenchmarkResult lookupBenchmark_CompactOrderBook(const CompactOrderBook& book, const Workload& w,
+                                                 const std::vector<size_t>& lookups, const BenchmarkConfig& cfg) {
+    return lookupBenchmark("CompactOrderBook", book, w, lookups, cfg);
+}
 
-    std::cout << "[OrderBook] Lookup " << numLookups << ": " << lookupTime.count() << " s\n";
-    return lookupTime.count();
+BenchmarkResult lookupBenchmark_OptimizedOrderBook(const OptimizedOrderBook& optOb, const Workload& w,
+                                                   const std::vector<size_t>& lookups, const BenchmarkConfig& cfg) {
+    return lookupBenchmark("OptimizedOrderBook", optOb, w, lookups, cfg);
 }
 
-double lookupBenchmark_OptimizedOrderBook(int numOrders, int numLookups) {
-    OptimizedOrderBook optOb(numOrders);
-    std::mt19937 rng(42);
-    std::uniform_real_distribution<double> priceDist(50.0, 150.0);
-    std::uniform_int_distribution<int> qtyDist(1, 1000);
-    for (int i = 0; i < numOrders; i++) {
-        std::string id = "OID" + std::to_string(i);
-        optOb.addOrder(id, priceDist(rng), qtyDist(rng), i % 2);
+// Same lookup workload split across shard writer threads, with reader threads
+// taking seqlock snapshots of every shard for the whole run. One in four writer
+// operations is a quantity amend so readers see a moving book. Per-op
+// latencies are not sampled here; the percentile columns stay at zero.
+BenchmarkResult lookupBenchmark_ShardedOrderBook(const Workload& w, const std::vector<size_t>& lookups,
+                                                 int numShards, int numReaders, const BenchmarkConfig& cfg) {
+    ShardedOrderBook book(numShards, w.ids.size() / numShards + 1);
+    loadBook(book, w);
+
+    // Each writer only replays the lookups for ids owned by its shard.
+    std::vector<std::vector<size_t>> shardLookups(numShards);
+    for (size_t idx : lookups) {
+        shardLookups[book.shardFor(w.ids[idx])].push_back(idx);
     }
 
-    std::mt19937 rng2(777);
-    std::uniform_int_distribution<int> idDist(0, numOrders - 1);
+    std::vector<double> seconds;
+    long long snapshots = 0, retries = 0;
+    for (int r = 0; r < cfg.warmupRuns + cfg.repetitions; r++) {
+        std::atomic<bool> stop{false};
+        std::atomic<long long> runSnapshots{0};
+        std::atomic<long long> runRetries{0};
+        std::vector<std::thread> readers;
+        for (int k = 0; k < numReaders; k++) {
+            readers.emplace_back([&]() {
+                long long n = 0, spins = 0;
+                PriceLevelInfo bid{}, ask{};
+                bool hasBid, hasAsk;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    spins += book.topOfBook(bid, ask, hasBid, hasAsk);
+                    n++;
+                }
+                runSnapshots.fetch_add(n);
+                runRetries.fetch_add(spins);
+            });
+        }
 
-    auto startLookup = std::chrono::high_resolution_clock::now();
-    for (int i = 0; i < numLookups; ++i) {
-        std::string id = "OID" + std::to_string(idDist(rng2));
-        bool found = optOb.findOrder(id);
-        (void)found;
+        auto a = bench_clock::now();
+        std::vector<std::thread> writers;
+        for (int s = 0; s < numShards; s++) {
+            writers.emplace_back([&, s]() {
+                auto& shard = book.shard(s);
+                const auto& mine = shardLookups[s];
+                for (size_t i = 0; i < mine.size(); i++) {
+                    size_t idx = mine[i];
+                    if (i % 4 == 0) {
+                        shard.modifyOrder(w.ids[idx], w.prices[idx], w.quantities[(idx + r) % w.ids.size()]);
+                    }
+                    else {
+                        bool found = shard.findOrder(w.ids[idx]);
+                        (void)found;
+                    }
+                }
+            });
+        }
+        for (auto& t : writers) t.join();
+        double elapsed = elapsedSec(a, bench_clock::now());
+        stop.store(true);
+        for (auto& t : readers) t.join();
+
+        if (r >= cfg.warmupRuns) {
+            seconds.push_back(elapsed);
+            snapshots += runSnapshots.load();
+            retries += runRetries.load();
+        }
     }
-    auto endLookup = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> lookupTime = endLookup - startLookup;
 
-    std::cout << "[OptimizedOrderBook] Lookup " << numLookups << ": " << lookupTime.count() << " s\n";
-    return lookupTime.count();
+    std::cout << "[ShardedOrderBook x" << numShards << ", " << numReaders << " readers] snapshots "
+              << snapshots << ", retries " << retries << "\n";
+    return summarize("ShardedOrderBook", "Lookup", (int)w.ids.size(), (int)lookups.size(), seconds, {});
 }
 
 // ================= main =================
-int main() {
+// Usage: main [repetitions] [warmupRuns]
+int main(int argc, char** argv) {
+    BenchmarkConfig cfg;
+    if (argc > 1) cfg.repetitions = std::max(1, std::atoi(argv[1]));
+    if (argc > 2) cfg.warmupRuns = std::max(0, std::atoi(argv[2]));
+
     const std::string csvFile = "benchmark_results.csv";
     writeCSVHeader(csvFile);
 
     std::vector<int> orderSizes = {10000, 50000, 100000, 200000, 500000};
     std::vector<int> lookupSizes = {1000, 10000, 100000, 500000};
+    std::vector<int> bulkLoadSizes = {10000, 100000, 1000000, 5000000};
+    std::vector<int> memorySizes = {100000, 1000000, 5000000};
+
+    const char* kernelName;
+    simd::selectExposureKernel(&kernelName);
+    std::cout << "Repetitions: " << cfg.repetitions << ", warmup: " << cfg.warmupRuns
+              << ", clock overhead per latency sample: " << clockOverheadNs() << " ns"
+              << ", exposure kernel: " << kernelName << "\n";
 
     for (int numOrders : orderSizes) {
         std::cout << "\n=== Benchmark for " << numOrders << " Orders ===\n";
-
-        auto baseResult = benchmark_baseline(numOrders);
-        appendToCSV(csvFile, "OrderBook_Benchmark", baseResult);
-
-        auto optResult = benchmark_optimized(numOrders);
-        appendToCSV(csvFile, "OptimizedOrderBook_Benchmark", optResult);
+        Workload w = makeWorkload(numOrders);
+
+        benchmark_book("OrderBook", [] { return std::make_unique<OrderBook>(); }, w, cfg, csvFile);
+        benchmark_book("OptimizedOrderBook", [&] { return std::make_unique<OptimizedOrderBook>(numOrders); },
+                       w, cfg, csvFile);
+        benchmark_book("CompactOrderBook", [&] { return std::make_unique<CompactOrderBook>(numOrders); },
+                       w, cfg, csvFile);
+
+        OrderBook ob;
+        loadBook(ob, w);
+        OptimizedOrderBook optOb(numOrders);
+        loadBook(optOb, w);
+        CompactOrderBook compactOb(numOrders);
+        loadBook(compactOb, w);
+        benchmark_bestPrice(optOb, numOrders, cfg, csvFile);
+        benchmark_exposure(w, cfg, csvFile);
+        benchmark_restore(w, cfg, csvFile);
 
         for (int numLookups : lookupSizes) {
-            double t1 = lookupBenchmark_OrderBook(numOrders, numLookups);
-            appendToCSV(csvFile, "OrderBook_Lookup", {numOrders,0,0,0,0}, numLookups, t1);
-
-            double t2 = lookupBenchmark_OptimizedOrderBook(numOrders, numLookups);
-            appendToCSV(csvFile, "OptimizedOrderBook_Lookup", {numOrders,0,0,0,0}, numLookups, t2);
+            std::vector<size_t> lookups = makeLookups(numOrders, numLookups, 666);
+            report(csvFile, lookupBenchmark_OrderBook(ob, w, lookups, cfg));
+            report(csvFile, lookupBenchmark_OptimizedOrderBook(optOb, w, lookups, cfg));
+            report(csvFile, lookupBenchmark_CompactOrderBook(compactOb, w, lookups, cfg));
+            report(csvFile, lookupBenchmark_ShardedOrderBook(w, lookups, 4, 2, cfg));
         }
     }
+
+    std::cout << "\n=== Bulk load ===\n";
+    for (int numOrders : bulkLoadSizes) {
+        benchmark_bulkLoad(numOrders, cfg, csvFile);
+    }
+
+    std::cout << "\n=== Memory per order ===\n";
+    const std::string memFile = "memory_results.csv";
+    {
+        std::ofstream file(memFile, std::ios::trunc);
+        file << "TestType,NumOrders,Bytes,BytesPerOrder,LoadSec\n";
+    }
+    for (int numOrders : memorySizes) {
+        benchmark_memory(numOrders, memFile);
+    }
     return 0;
-}
\ No newline at end of file
+}
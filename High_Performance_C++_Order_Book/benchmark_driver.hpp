@@ -0,0 +1,316 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "event_log.hpp"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+
+// Shared benchmark driver for the three order book variants (vector,
+// vector_without_tunning, stl_heaps). Each variant's main.cpp wraps its book
+// in a small adapter and calls runComparison(); every variant replays the same
+// event stream (same seed, generated without std distributions, so it is
+// identical across standard libraries), or a recorded event_log.hpp file,
+// and writes its rows into one CSV. Trade events are counted but not applied.
+//
+// An adapter is default-constructible (a fresh, empty book) and provides
+//     bool insert(const bench::Event&);
+//     bool amend(const bench::Event&);
+//     bool remove(const bench::Event&);
+//     uint64_t top();      // best bid + best ask, any value the book has
+namespace bench {
+
+struct StreamConfig {
+    size_t events = 1'000'000;
+    double insertShare = 0.45;    // the rest split between amends and deletes
+    double amendShare = 0.35;
+    uint32_t maxPrice = 5000;     // prices are 0..maxPrice
+    uint32_t maxQty = 500;        // quantities are 1..maxQty
+    uint64_t seed = 123456789;
+};
+
+// Interleaved insert/amend/delete stream. Amends and deletes always target a
+// live order; amends never set qty to 0.
+inline std::vector<Event> makeEventStream(const StreamConfig& cfg = StreamConfig()) {
+    std::mt19937_64 rng(cfg.seed);
+    auto below = [&](uint64_t n) { return rng() % n; };
+    std::vector<Event> events;
+    std::vector<uint64_t> live;
+    events.reserve(cfg.events);
+    live.reserve(cfg.events);
+    uint64_t nextId = 1;
+    const uint64_t insertCut = (uint64_t)(cfg.insertShare * 1000);
+    const uint64_t amendCut = insertCut + (uint64_t)(cfg.amendShare * 1000);
+    for (size_t i = 0; i < cfg.events; ++i) {
+        Event e{};
+        uint64_t u = below(1000);
+        if (u < insertCut || live.empty()) {
+            e.type = EventType::Insert;
+            e.id = nextId++;
+            e.price = (uint32_t)below(cfg.maxPrice + 1);
+            e.qty = (uint32_t)below(cfg.maxQty) + 1;
+            e.buy = below(2) == 0;
+            live.push_back(e.id);
+        }
+        else if (u < amendCut) {
+            e.type = EventType::Amend;
+            e.id = live[below(live.size())];
+            e.qty = (uint32_t)below(cfg.maxQty) + 1;
+        }
+        else {
+            e.type = EventType::Delete;
+            size_t pos = below(live.size());
+            e.id = live[pos];
+            std::swap(live[pos], live.back());
+            live.pop_back();
+        }
+        events.push_back(e);
+    }
+    return events;
+}
+
+// Cycle counter where there is one (invariant TSC on current x86), otherwise
+// steady_clock nanoseconds. Convert with nsPerTick().
+inline uint64_t ticks() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Calibrated once against steady_clock over ~50 ms.
+inline double nsPerTick() {
+    static const double ratio = [] {
+        using sc = std::chrono::steady_clock;
+        auto t0 = sc::now();
+        uint64_t c0 = ticks();
+        while (sc::now() - t0 < std::chrono::milliseconds(50)) {
+        }
+        uint64_t c1 = ticks();
+        double ns = std::chrono::duration<double, std::nano>(sc::now() - t0).count();
+        return c1 > c0 ? ns / (double)(c1 - c0) : 1.0;
+    }();
+    return ratio;
+}
+
+// Cost of one ticks() pair, in ticks (smallest of many back-to-back reads);
+// subtracted from every sample.
+inline uint64_t timerOverhead() {
+    static const uint64_t overhead = [] {
+        uint64_t best = ~uint64_t(0);
+        for (int i = 0; i < 10000; ++i) {
+            uint64_t t0 = ticks();
+            uint64_t t1 = ticks();
+            best = std::min(best, t1 - t0);
+        }
+        return best;
+    }();
+    return overhead;
+}
+
+// Log-linear histogram of tick counts: exact below 64, then 32 sub-buckets
+// per power of two (about 3% resolution). Fixed size, no allocation per sample.
+class LatencyHistogram {
+public:
+    void add(uint64_t v) {
+        counts[bucketOf(v)]++;
+        n++;
+        sum += v;
+        maxSeen = std::max(maxSeen, v);
+    }
+
+    uint64_t count() const { return n; }
+    double meanTicks() const { return n ? (double)sum / n : 0.0; }
+    uint64_t totalTicks() const { return sum; }
+    uint64_t maxTicks() const { return maxSeen; }
+
+    // Smallest bucket bound with at least q of the samples at or below it.
+    uint64_t percentileTicks(double q) const {
+        if (n == 0) {
+            return 0;
+        }
+        uint64_t target = (uint64_t)(q * (n - 1)) + 1;
+        uint64_t seen = 0;
+        for (size_t b = 0; b < BUCKETS; ++b) {
+            seen += counts[b];
+            if (seen >= target) {
+                return std::min(upperBound(b), maxSeen);
+            }
+        }
+        return maxSeen;
+    }
+
+private:
+    static constexpr size_t SUB_BITS = 5;
+    static constexpr size_t LINEAR = 64;
+    static constexpr size_t BUCKETS = LINEAR + (64 - 6) * (size_t(1) << SUB_BITS);
+
+    uint64_t counts[BUCKETS] = {};
+    uint64_t n = 0;
+    uint64_t sum = 0;
+    uint64_t maxSeen = 0;
+
+    static size_t bucketOf(uint64_t v) {
+        if (v < LINEAR) {
+            return (size_t)v;
+        }
+        size_t msb = 63 - (size_t)clz64(v);                  // >= 6
+        size_t sub = (size_t)(v >> (msb - SUB_BITS)) & ((size_t(1) << SUB_BITS) - 1);
+        return LINEAR + (msb - 6) * (size_t(1) << SUB_BITS) + sub;
+    }
+
+    static uint64_t upperBound(size_t b) {
+        if (b < LINEAR) {
+            return b;
+        }
+        size_t msb = (b - LINEAR) / (size_t(1) << SUB_BITS) + 6;
+        size_t sub = (b - LINEAR) % (size_t(1) << SUB_BITS);
+        uint64_t low = (uint64_t(1) << msb) | ((uint64_t)sub << (msb - SUB_BITS));
+        return low + (uint64_t(1) << (msb - SUB_BITS)) - 1;
+    }
+
+    static int clz64(uint64_t v) {
+#if defined(_MSC_VER)
+        unsigned long idx;
+        _BitScanReverse64(&idx, v);
+        return 63 - (int)idx;
+#else
+        return __builtin_clzll(v);
+#endif
+    }
+};
+
+struct OpStats {
+    const char* op;
+    LatencyHistogram hist;
+};
+
+// Replays events through a fresh Book twice: once untimed for overall
+// throughput, once timing every event (and a top-of-book query every
+// topEvery events). Prints a summary and replaces this method's rows in
+// csvPath, keeping the other methods' rows, so each variant can be rerun on
+// its own.
+template <typename Book>
+void runComparison(const std::string& method, const Event* first, size_t count,
+                   const std::string& csvPath, size_t topEvery = 16) {
+    std::cout << "\n==== COMPARISON DRIVER (" << method << ", " << count << " events) ====\n";
+    uint64_t sink = 0;
+    auto apply = [](Book& book, const Event& e) {
+        switch (e.type) {
+            case EventType::Insert: return book.insert(e);
+            case EventType::Amend: return book.amend(e);
+            case EventType::Delete: return book.remove(e);
+            default: return false;
+        }
+    };
+    const Event* last = first + count;
+
+    double overallMops = 0;
+    {
+        Book book;
+        auto t0 = std::chrono::steady_clock::now();
+        for (const Event* e = first; e != last; ++e) {
+            sink += apply(book, *e);
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        overallMops = count / std::chrono::duration<double, std::micro>(t1 - t0).count();
+        sink += book.top();
+    }
+
+    OpStats stats[4] = { { "Insert", {} }, { "Amend", {} }, { "Delete", {} }, { "TopOfBook", {} } };
+    const uint64_t overhead = timerOverhead();
+    auto sample = [&](LatencyHistogram& h, uint64_t t0, uint64_t t1) {
+        uint64_t d = t1 - t0;
+        h.add(d > overhead ? d - overhead : 0);
+    };
+    {
+        Book book;
+        for (size_t i = 0; i < count; ++i) {
+            const Event& e = first[i];
+            if (e.type == EventType::Trade) {
+                continue;
+            }
+            uint64_t t0 = ticks();
+            sink += apply(book, e);
+            uint64_t t1 = ticks();
+            sample(stats[(size_t)e.type].hist, t0, t1);
+            if (topEvery && i % topEvery == 0) {
+                t0 = ticks();
+                sink += book.top();
+                t1 = ticks();
+                sample(stats[3].hist, t0, t1);
+            }
+        }
+    }
+
+    const double k = nsPerTick();
+    std::vector<std::string> rows;
+    rows.push_back(method + ",All," + std::to_string(count) + "," + std::to_string(overallMops) + ",,,,,,");
+    std::cout << "Overall Rate (untimed pass): " << overallMops << " Mops/s\n";
+    for (const OpStats& s : stats) {
+        const LatencyHistogram& h = s.hist;
+        double rate = h.totalTicks() ? 1e3 * h.count() / (h.totalTicks() * k) : 0.0;
+        std::cout << s.op << ": " << rate << " Mops/s, "
+                  << "Mean: " << h.meanTicks() * k << " "
+                  << "Median: " << h.percentileTicks(0.5) * k << " "
+                  << "90th: " << h.percentileTicks(0.9) * k << " "
+                  << "99th: " << h.percentileTicks(0.99) * k << " "
+                  << "99.9th: " << h.percentileTicks(0.999) * k << " "
+                  << "Max: " << h.maxTicks() * k << " ns\n";
+        rows.push_back(method + "," + s.op + "," + std::to_string(h.count()) + "," + std::to_string(rate) + ","
+                       + std::to_string(h.meanTicks() * k) + "," + std::to_string(h.percentileTicks(0.5) * k) + ","
+                       + std::to_string(h.percentileTicks(0.9) * k) + "," + std::to_string(h.percentileTicks(0.99) * k) + ","
+                       + std::to_string(h.percentileTicks(0.999) * k) + "," + std::to_string(h.maxTicks() * k));
+    }
+    std::cout << "Timer overhead subtracted: " << overhead * k << " ns (checksum " << sink << ")\n";
+
+    const std::string header = "Method,Operation,Count,RateMops,MeanNs,MedianNs,P90Ns,P99Ns,P999Ns,MaxNs";
+    std::vector<std::string> kept;
+    {
+        std::ifstream in(csvPath);
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line != header && !line.empty() && line.compare(0, method.size() + 1, method + ",") != 0) {
+                kept.push_back(line);
+            }
+        }
+    }
+    std::ofstream out(csvPath, std::ios::binary);
+    out << header << '\n';
+    for (const std::string& line : kept) out << line << '\n';
+    for (const std::string& line : rows) out << line << '\n';
+}
+
+template <typename Book>
+void runComparison(const std::string& method, const std::vector<Event>& events,
+                   const std::string& csvPath, size_t topEvery = 16) {
+    runComparison<Book>(method, events.data(), events.size(), csvPath, topEvery);
+}
+
+// Replays the event log at logPath straight from its mapping (rows tagged
+// method@log), or the default synthetic stream if logPath is empty.
+template <typename Book>
+void replayComparison(const std::string& method, const std::string& logPath, const std::string& csvPath) {
+    if (logPath.empty()) {
+        runComparison<Book>(method, makeEventStream(), csvPath);
+        return;
+    }
+    EventLogReader log;
+    if (log.open(logPath)) {
+        runComparison<Book>(method + "@log", log.data(), log.size(), csvPath);
+    }
+}
+
+}  // namespace bench
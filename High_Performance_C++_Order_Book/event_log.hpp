@@ -0,0 +1,286 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+// Binary event log for order book replay. Layout (little-endian):
+//
+//     LogHeader     64 bytes
+//     Event[n]      24 bytes each, starting at byte 64
+//     LogBlock[m]   block index, at header.indexOffset
+//
+// Records are grouped into blocks of at most blockRecords events. A block
+// stores the absolute timestamp of its first event, and each event stores
+// tsDelta (ns since that base). A new block starts early if a delta would not
+// fit in 32 bits. Events are used straight from the mapping: EventLogReader
+// hands out const Event* into the file, with no parsing and no copy.
+namespace bench {
+
+enum class EventType : uint8_t {
+    Insert = 0,
+    Amend = 1,
+    Delete = 2,
+    Trade = 3       // trade print against resting order id; book changes come as Amend/Delete
+};
+
+struct Event {
+    uint64_t id;
+    uint32_t price;
+    uint32_t qty;
+    uint32_t tsDelta;    // ns since the start of the event's log block; 0 if not from a log
+    EventType type;
+    bool buy;
+    uint16_t reserved;
+};
+
+static_assert(sizeof(Event) == 24, "Event is the on-disk record and must stay 24 bytes");
+
+struct LogHeader {
+    char magic[8];           // "OBEVLOG1"
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t recordCount;
+    uint64_t indexOffset;
+    uint64_t blockCount;
+    uint32_t blockRecords;
+    uint32_t reserved[5];
+};
+
+static_assert(sizeof(LogHeader) == 64, "LogHeader must stay 64 bytes");
+
+struct LogBlock {
+    uint64_t baseTimestamp;  // ns, timestamp of the block's first event
+    uint64_t firstRecord;
+};
+
+static constexpr char LOG_MAGIC[8] = { 'O', 'B', 'E', 'V', 'L', 'O', 'G', '1' };
+static constexpr uint32_t LOG_VERSION = 1;
+
+
+// Appends events with their absolute timestamps (ns, non-decreasing) and
+// writes the index and final header on close().
+class EventLogWriter {
+public:
+    explicit EventLogWriter(uint32_t blockRecords = 4096) : blockRecords(blockRecords ? blockRecords : 1) {}
+    ~EventLogWriter() { close(); }
+
+    EventLogWriter(const EventLogWriter&) = delete;
+    EventLogWriter& operator=(const EventLogWriter&) = delete;
+
+    bool open(const std::string& path) {
+        close();
+        file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            std::cerr << "Error: could not create " << path << "\n";
+            return false;
+        }
+        std::setvbuf(file, nullptr, _IOFBF, 1 << 20);
+        LogHeader placeholder{};
+        count = 0;
+        lastTimestamp = 0;
+        blocks.clear();
+        return std::fwrite(&placeholder, sizeof(placeholder), 1, file) == 1;
+    }
+
+    // Returns false if the timestamp goes backwards or the write fails.
+    bool append(uint64_t timestamp, Event e) {
+        if (!file || (count && timestamp < lastTimestamp)) {
+            return false;
+        }
+        if (blocks.empty() || count - blocks.back().firstRecord >= blockRecords
+            || timestamp - blocks.back().baseTimestamp > UINT32_MAX) {
+            blocks.push_back(LogBlock{ timestamp, count });
+        }
+        e.tsDelta = (uint32_t)(timestamp - blocks.back().baseTimestamp);
+        e.reserved = 0;
+        lastTimestamp = timestamp;
+        count++;
+        return std::fwrite(&e, sizeof(e), 1, file) == 1;
+    }
+
+    uint64_t size() const { return count; }
+
+    bool close() {
+        if (!file) {
+            return true;
+        }
+        LogHeader h{};
+        std::memcpy(h.magic, LOG_MAGIC, sizeof(h.magic));
+        h.version = LOG_VERSION;
+        h.recordSize = sizeof(Event);
+        h.recordCount = count;
+        h.indexOffset = sizeof(LogHeader) + count * sizeof(Event);
+        h.blockCount = blocks.size();
+        h.blockRecords = blockRecords;
+        bool ok = blocks.empty() || std::fwrite(blocks.data(), sizeof(LogBlock), blocks.size(), file) == blocks.size();
+        ok = ok && std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(&h, sizeof(h), 1, file) == 1;
+        ok = (std::fclose(file) == 0) && ok;
+        file = nullptr;
+        return ok;
+    }
+
+private:
+    std::FILE* file = nullptr;
+    uint32_t blockRecords;
+    uint64_t count = 0;
+    uint64_t lastTimestamp = 0;
+    std::vector<LogBlock> blocks;
+};
+
+
+// Read-only memory mapping of a log. The file is prefaulted where the OS
+// allows it (MAP_POPULATE) and advised for sequential access.
+class EventLogReader {
+public:
+    EventLogReader() = default;
+    ~EventLogReader() { close(); }
+
+    EventLogReader(const EventLogReader&) = delete;
+    EventLogReader& operator=(const EventLogReader&) = delete;
+
+    bool open(const std::string& path) {
+        close();
+        if (!map(path)) {
+            std::cerr << "Error: could not map " << path << "\n";
+            return false;
+        }
+        const LogHeader* h = header();
+        if (length < sizeof(LogHeader) || std::memcmp(h->magic, LOG_MAGIC, sizeof(LOG_MAGIC)) != 0
+            || h->version != LOG_VERSION || h->recordSize != sizeof(Event)
+            || h->recordCount > length / sizeof(Event) || h->blockCount > length / sizeof(LogBlock)
+            || h->indexOffset != sizeof(LogHeader) + h->recordCount * sizeof(Event)
+            || h->indexOffset + h->blockCount * sizeof(LogBlock) > length
+            || (h->recordCount != 0) != (h->blockCount != 0)) {
+            std::cerr << "Error: " << path << " is not a valid event log\n";
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (base) {
+#if defined(_WIN32)
+            UnmapViewOfFile(base);
+#else
+            munmap(base, length);
+#endif
+        }
+        base = nullptr;
+        length = 0;
+    }
+
+    bool isOpen() const { return base != nullptr; }
+
+    const Event* data() const { return reinterpret_cast<const Event*>(bytes() + sizeof(LogHeader)); }
+    size_t size() const { return base ? (size_t)header()->recordCount : 0; }
+    const Event* begin() const { return data(); }
+    const Event* end() const { return data() + size(); }
+
+    size_t blockCount() const { return base ? (size_t)header()->blockCount : 0; }
+    const LogBlock* blocks() const { return reinterpret_cast<const LogBlock*>(bytes() + header()->indexOffset); }
+
+    // Block holding record i.
+    size_t blockOf(size_t i) const {
+        const LogBlock* b = blocks();
+        return (size_t)(std::upper_bound(b, b + blockCount(), (uint64_t)i,
+                        [](uint64_t rec, const LogBlock& blk) { return rec < blk.firstRecord; }) - b) - 1;
+    }
+
+    // Absolute timestamp of record i (one index search).
+    uint64_t timestamp(size_t i) const {
+        return blocks()[blockOf(i)].baseTimestamp + data()[i].tsDelta;
+    }
+
+    // First record with timestamp >= ts, or size(). Every block from the
+    // first one based at >= ts on starts at or after ts, so only the block
+    // before it needs scanning.
+    size_t seek(uint64_t ts) const {
+        const LogBlock* b = blocks();
+        size_t n = blockCount();
+        size_t k = (size_t)(std::lower_bound(b, b + n, ts,
+                            [](const LogBlock& blk, uint64_t t) { return blk.baseTimestamp < t; }) - b);
+        if (k == 0) {
+            return 0;
+        }
+        size_t last = (k < n) ? (size_t)b[k].firstRecord : size();
+        for (size_t i = (size_t)b[k - 1].firstRecord; i < last; ++i) {
+            if (b[k - 1].baseTimestamp + data()[i].tsDelta >= ts) {
+                return i;
+            }
+        }
+        return last;
+    }
+
+private:
+    void* base = nullptr;
+    size_t length = 0;
+
+    const char* bytes() const { return static_cast<const char*>(base); }
+    const LogHeader* header() const { return reinterpret_cast<const LogHeader*>(base); }
+
+    bool map(const std::string& path) {
+#if defined(_WIN32)
+        HANDLE f = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                               FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (f == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER sz;
+        HANDLE m = nullptr;
+        if (GetFileSizeEx(f, &sz) && sz.QuadPart > 0) {
+            m = CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        }
+        CloseHandle(f);
+        if (!m) {
+            return false;
+        }
+        base = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(m);
+        length = base ? (size_t)sz.QuadPart : 0;
+        return base != nullptr;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+        int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+        flags |= MAP_POPULATE;
+#endif
+        void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, flags, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            return false;
+        }
+        madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+        base = p;
+        length = (size_t)st.st_size;
+        return true;
+#endif
+    }
+};
+
+}  // namespace bench
@@ -0,0 +1,234 @@
+#include "benchmark_driver.hpp"
+#include "event_log.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+// Event log utility.
+//
+//     eventlog_tool convert <capture.txt> <out.evlog>   text capture -> binary log
+//     eventlog_tool dump <in.evlog> [first] [count]     binary log -> text capture
+//     eventlog_tool generate <out.evlog> [events]       benchmark stream -> binary log
+//     eventlog_tool bench <in.evlog> [passes]           read throughput from the mapping
+//
+// Text captures have one event per line, fields separated by spaces; blank
+// lines and lines starting with '#' are skipped. Timestamps are ns and must
+// not decrease. Sides are B or S.
+//
+//     <ts> N <id> <side> <price> <qty>     new order
+//     <ts> A <id> <qty>                    amend quantity
+//     <ts> D <id>                          delete
+//     <ts> T <id> <price> <qty>            trade against resting order <id>
+
+using clk = std::chrono::steady_clock;
+
+static bool parseUInt(const char*& p, uint64_t& out) {
+    while (*p == ' ' || *p == '\t') ++p;
+    if (*p < '0' || *p > '9') {
+        return false;
+    }
+    uint64_t v = 0;
+    while (*p >= '0' && *p <= '9') {
+        uint64_t d = (uint64_t)(*p++ - '0');
+        if (v > (UINT64_MAX - d) / 10) {
+            return false;
+        }
+        v = v * 10 + d;
+    }
+    out = v;
+    return true;
+}
+
+static bool parseChar(const char*& p, char& out) {
+    while (*p == ' ' || *p == '\t') ++p;
+    if (!*p) {
+        return false;
+    }
+    out = *p++;
+    return *p == ' ' || *p == '\t' || *p == '\0';
+}
+
+static bool parseLine(const std::string& line, uint64_t& ts, bench::Event& e) {
+    const char* p = line.c_str();
+    uint64_t id = 0, price = 0, qty = 0;
+    char type = 0, side = 0;
+    e = bench::Event{};
+    if (!parseUInt(p, ts) || !parseChar(p, type) || !parseUInt(p, id)) {
+        return false;
+    }
+    e.id = id;
+    switch (type) {
+        case 'N':
+            if (!parseChar(p, side) || (side != 'B' && side != 'S') || !parseUInt(p, price) || !parseUInt(p, qty)) {
+                return false;
+            }
+            e.type = bench::EventType::Insert;
+            e.buy = side == 'B';
+            break;
+        case 'A':
+            if (!parseUInt(p, qty)) {
+                return false;
+            }
+            e.type = bench::EventType::Amend;
+            break;
+        case 'D':
+            e.type = bench::EventType::Delete;
+            break;
+        case 'T':
+            if (!parseUInt(p, price) || !parseUInt(p, qty)) {
+                return false;
+            }
+            e.type = bench::EventType::Trade;
+            break;
+        default:
+            return false;
+    }
+    if (price > UINT32_MAX || qty > UINT32_MAX) {
+        return false;
+    }
+    e.price = (uint32_t)price;
+    e.qty = (uint32_t)qty;
+    while (*p == ' ' || *p == '\t' || *p == '\r') ++p;
+    return *p == '\0';
+}
+
+int convert(const std::string& in, const std::string& out) {
+    std::ifstream file(in);
+    if (!file.is_open()) {
+        std::cerr << "Error: could not open file " << in << "\n";
+        return 1;
+    }
+    bench::EventLogWriter writer;
+    if (!writer.open(out)) {
+        return 1;
+    }
+    std::string line;
+    size_t lineNo = 0;
+    while (std::getline(file, line)) {
+        ++lineNo;
+        if (line.empty() || line[0] == '#' || line == "\r") continue;
+        uint64_t ts;
+        bench::Event e;
+        const char* problem = !parseLine(line, ts, e) ? "malformed event"
+                            : !writer.append(ts, e) ? "timestamp goes backwards or write failed"
+                            : nullptr;
+        if (problem) {
+            std::cerr << in << ":" << lineNo << ": " << problem << ": " << line << "\n";
+            writer.close();
+            std::remove(out.c_str());
+            return 1;
+        }
+    }
+    size_t n = writer.size();
+    if (!writer.close()) {
+        std::cerr << "Error: could not finish " << out << "\n";
+        return 1;
+    }
+    std::cout << "Wrote " << n << " events to " << out << "\n";
+    return 0;
+}
+
+int dump(const std::string& in, size_t first, size_t count) {
+    bench::EventLogReader log;
+    if (!log.open(in)) {
+        return 1;
+    }
+    size_t last = std::min(log.size(), first + std::min(count, log.size()));
+    std::string out;
+    for (size_t i = first; i < last; ++i) {
+        const bench::Event& e = log.data()[i];
+        out += std::to_string(log.timestamp(i));
+        switch (e.type) {
+            case bench::EventType::Insert:
+                out += " N " + std::to_string(e.id) + (e.buy ? " B " : " S ") + std::to_string(e.price) + " " + std::to_string(e.qty);
+                break;
+            case bench::EventType::Amend:
+                out += " A " + std::to_string(e.id) + " " + std::to_string(e.qty);
+                break;
+            case bench::EventType::Delete:
+                out += " D " + std::to_string(e.id);
+                break;
+            default:
+                out += " T " + std::to_string(e.id) + " " + std::to_string(e.price) + " " + std::to_string(e.qty);
+                break;
+        }
+        out += '\n';
+        if (out.size() > (1 << 16)) {
+            std::cout << out;
+            out.clear();
+        }
+    }
+    std::cout << out;
+    return 0;
+}
+
+// Writes the comparison driver's synthetic stream, one event per microsecond.
+int generate(const std::string& out, size_t events) {
+    bench::StreamConfig cfg;
+    cfg.events = events;
+    std::vector<bench::Event> stream = bench::makeEventStream(cfg);
+    bench::EventLogWriter writer;
+    if (!writer.open(out)) {
+        return 1;
+    }
+    for (size_t i = 0; i < stream.size(); ++i) {
+        writer.append(1'000 * (uint64_t)i, stream[i]);
+    }
+    if (!writer.close()) {
+        std::cerr << "Error: could not finish " << out << "\n";
+        return 1;
+    }
+    std::cout << "Wrote " << stream.size() << " events to " << out << "\n";
+    return 0;
+}
+
+// Touches every field of every record, as a replay would.
+int bench_read(const std::string& in, int passes) {
+    auto t0 = clk::now();
+    bench::EventLogReader log;
+    if (!log.open(in)) {
+        return 1;
+    }
+    auto t1 = clk::now();
+    std::cout << "Mapped " << log.size() << " events (" << log.blockCount() << " blocks) in "
+              << std::chrono::duration<double, std::milli>(t1 - t0).count() << " ms\n";
+    uint64_t sink = 0;
+    for (int pass = 0; pass < passes; ++pass) {
+        auto s0 = clk::now();
+        for (const bench::Event& e : log) {
+            sink += e.id + e.price + e.qty + e.tsDelta + (uint64_t)e.type + e.buy;
+        }
+        double sec = std::chrono::duration<double>(clk::now() - s0).count();
+        std::cout << "Pass " << pass + 1 << ": " << log.size() / sec / 1e6 << " Mevents/s, "
+                  << log.size() * sizeof(bench::Event) / sec / 1e9 << " GB/s\n";
+    }
+    std::cout << "(checksum " << sink << ")\n";
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    std::ios::sync_with_stdio(false);
+    std::string cmd = argc > 1 ? argv[1] : "";
+    if (cmd == "convert" && argc == 4) {
+        return convert(argv[2], argv[3]);
+    }
+    if (cmd == "dump" && argc >= 3) {
+        size_t first = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 0;
+        size_t count = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : SIZE_MAX;
+        return dump(argv[2], first, count);
+    }
+    if (cmd == "generate" && argc >= 3) {
+        return generate(argv[2], argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1'000'000);
+    }
+    if (cmd == "bench" && argc >= 3) {
+        return bench_read(argv[2], argc > 3 ? std::atoi(argv[3]) : 5);
+    }
+    std::cerr << "usage: eventlog_tool convert <capture.txt> <out.evlog>\n"
+              << "       eventlog_tool dump <in.evlog> [first] [count]\n"
+              << "       eventlog_tool generate <out.evlog> [events]\n"
+              << "       eventlog_tool bench <in.evlog> [passes]\n";
+    return 2;
+}
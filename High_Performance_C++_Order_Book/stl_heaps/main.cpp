@@ -1,4 +1,5 @@
 #include "orderbook_new.hpp"
+#include "../benchmark_driver.hpp"
 #include <chrono>
 #include <random>
 #include <iostream>
@@ -204,11 +205,87 @@ void benchmark_run(size_t N = 1'000'000) {
 
 }
 
-int main() {
+// Best-price query latency under steady churn: a 100k-order book takes N
+// events (half inserts, half deletes of random live orders), and bestBid() +
+// bestAsk() are timed after each one.
+void benchmark_best(size_t N = 1'000'000) {
+    std::cout << "\n==== BEST PRICE UNDER CHURN (" << N << " events) ====\n";
+    OrderBookNew ob;
+    std::uniform_int_distribution<int> qty(1, 500);
+    std::uniform_int_distribution<int> price(0, 5000);
+    std::uniform_int_distribution<int> side(0, 1);
+
+    id_t nextId = 1;
+    std::vector<id_t> live;
+    auto insert = [&]() {
+        Order o;
+        o.id = nextId++;
+        o.price = (price_t)price(rng);
+        o.qty = (qty_t)qty(rng);
+        o.side = side(rng) ? Side::Buy : Side::Sell;
+        if (ob.newOrder(o)) live.push_back(o.id);
+    };
+    while (live.size() < 100'000) insert();
+
+    std::vector<double> latencies;
+    latencies.reserve(N);
+    price_t sink = 0;
+    for (size_t i = 0; i < N; ++i) {
+        if (rng() % 2) {
+            insert();
+        }
+        else {
+            size_t pos = rng() % live.size();
+            ob.deleteOrder(live[pos]);
+            std::swap(live[pos], live.back());
+            live.pop_back();
+        }
+        auto t0 = clk::now();
+        sink += ob.bestBid() + ob.bestAsk();
+        auto t1 = clk::now();
+        latencies.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count());
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << "Best Bid+Ask: ";
+    std::cout << "Median: " << latencies[latencies.size()/2] << " " 
+         << "Min: " << latencies[0] << " " 
+         << "Max: " << latencies.back() << " "
+         << "90th: " << latencies[(int)(0.9 * latencies.size())] << " "
+         << "99th: " << latencies[(int)(0.99 * latencies.size())] << " ns\n";
+    std::cout << "Live orders: " << ob.totalOrders() << " | Levels: "
+         << ob.levelCount(Side::Buy) << " bid, " << ob.levelCount(Side::Sell) << " ask"
+         << " (checksum " << sink << ")\n";
+}
+
+// Adapter for the shared comparison driver (../benchmark_driver.hpp).
+struct ComparisonBook {
+    OrderBookNew ob;
+    bool insert(const bench::Event& e) {
+        Order o;
+        o.id = e.id;
+        o.price = (price_t)e.price;
+        o.qty = (qty_t)e.qty;
+        o.side = e.buy ? Side::Buy : Side::Sell;
+        return ob.newOrder(o);
+    }
+    bool amend(const bench::Event& e) { return ob.amendOrder(e.id, e.qty); }
+    bool remove(const bench::Event& e) { return ob.deleteOrder(e.id); }
+    uint64_t top() { return (uint64_t)ob.bestBid() + ob.bestAsk(); }
+};
+
+// Optional argument: an event log (see ../event_log.hpp) to replay instead.
+void benchmark_compare(const std::string& logPath = "") {
+    bench::replayComparison<ComparisonBook>("stl_heaps", logPath, "../benchmark_comparison.csv");
+}
+
+int main(int argc, char** argv) {
     std::ios::sync_with_stdio(false);
     std::cin.tie(nullptr);
 
     //unit_tests();
     benchmark_run(1'000'000);
+    benchmark_best();
+    benchmark_compare(argc > 1 ? argv[1] : "");
     return 0;
 }
@@ -2,7 +2,6 @@
 #include <cstdint>
 #include <vector>
 #include <map>
-#include <queue>
 #include <unordered_map>
 #include <stdexcept>
 #include <algorithm>
@@ -33,13 +32,15 @@ struct PriceLevel {
 
 class OrderBookNew {
 public:
+    static constexpr qty_t MAX_QTY = 0x7FFFFFFF;   // per order; see Meta
+
     explicit OrderBookNew(size_t maxOrders = 1'000'000) {
         // id2price.reserve(maxOrders); // avoid rehash
         id2meta.reserve(maxOrders); // avoid rehash
     }
 
     bool newOrder(const Order& o) {
-        if (o.qty == 0) {
+        if (o.qty == 0 || o.qty > MAX_QTY) {
             return false;
         }
         // if (id2price.count(o.id)) {
@@ -49,19 +50,11 @@ public:
             return false;
         }
 
-        auto& lvl = levels[o.price];
+        auto& lvl = sideLevels(o.side)[o.price];
         lvl.totalQty += o.qty;
         lvl.orderCount += 1;
         // id2price[o.id] = o.price;
-        id2meta.emplace(o.id, std::make_pair(o.price, o.qty));
-
-        if (o.side == Side::Buy) {
-            bidHeap.push(o.price);
-        }
-        else {
-            askHeap.push(o.price);
-        }
-
+        id2meta.emplace(o.id, Meta{ o.price, o.qty, o.side == Side::Sell });
         return true;
     }
 
@@ -74,24 +67,27 @@ public:
         if (it == id2meta.end()){
             return false;
         }
+        if (newQty == 0) {
+            return deleteOrder(id);
+        }
+        if (newQty > MAX_QTY) {
+            return false;
+        }
 
-        price_t price = it->second.first;
-        qty_t oldQ = it->second.second;
-
-        auto lvlIt = levels.find(price);
+        Meta& m = it->second;
+        auto& levels = sideLevels(m.side());
+        auto lvlIt = levels.find(m.price);
 
         if (lvlIt == levels.end()) {
             return false;
         }
-        if (newQty > oldQ) {
-            lvlIt->second.totalQty += (newQty - oldQ);
+        if (newQty > m.qty) {
+            lvlIt->second.totalQty += (newQty - m.qty);
         } 
         else {
-            lvlIt->second.totalQty -= (oldQ - newQty);
-        }
-        if (newQty == 0) {
-            return deleteOrder(id);
+            lvlIt->second.totalQty -= (m.qty - newQty);
         }
+        m.qty = newQty;
         return true;
     }
 
@@ -105,19 +101,14 @@ public:
             return false;
         }
 
-        price_t p = it->second.first;
-        qty_t q = it->second.second;
-
-        auto lvlIt = levels.find(p);
+        Meta m = it->second;
+        auto& levels = sideLevels(m.side());
+        auto lvlIt = levels.find(m.price);
         if (lvlIt != levels.end()) {
-            if (lvlIt->second.totalQty > 0) {
-                lvlIt->second.totalQty -= q;
-            }
-            else {
-                lvlIt->second.totalQty = 0;
-            }
-            if (lvlIt->second.orderCount > 0) {
-                lvlIt->second.orderCount--;
+            PriceLevel& lvl = lvlIt->second;
+            lvl.totalQty -= m.qty;
+            if (--lvl.orderCount == 0) {
+                levels.erase(lvlIt);
             }
         }
 
@@ -126,28 +117,14 @@ public:
         return true;
     }
 
-    price_t bestBid() {
-        while (!bidHeap.empty()) {
-            price_t p = bidHeap.top();
-            auto it = levels.find(p);
-            if (it != levels.end() && it->second.orderCount > 0) {
-                return p;
-            }
-            bidHeap.pop();
-        }
-        return 0;
+    // Each side's map holds only its active levels, so the best price is
+    // the map's far end: O(1), however many orders have come and gone.
+    price_t bestBid() const {
+        return bidLevels.empty() ? 0 : bidLevels.rbegin()->first;
     }
 
-    price_t bestAsk() {
-        while (!askHeap.empty()) {
-            price_t p = askHeap.top();
-            auto it = levels.find(p);
-            if (it != levels.end() && it->second.orderCount > 0) {
-                return p;
-            }
-            askHeap.pop();
-        }
-        return UINT32_MAX;
+    price_t bestAsk() const {
+        return askLevels.empty() ? UINT32_MAX : askLevels.begin()->first;
     }
 
     size_t totalOrders() const { 
@@ -155,19 +132,34 @@ public:
         return id2meta.size();
     }
 
+    // Active price levels on one side.
+    size_t levelCount(Side s) const {
+        return s == Side::Buy ? bidLevels.size() : askLevels.size();
+    }
+
     void clear() {
         // id2price.clear();
         id2meta.clear();
-        levels.clear();
-        bidHeap = {};
-        askHeap = {};
+        bidLevels.clear();
+        askLevels.clear();
     }
 
 private:
+    // 8 bytes, so id2meta nodes stay as small as before the side was added.
+    struct Meta {
+        price_t price;
+        qty_t qty : 31;
+        qty_t sell : 1;
+        Side side() const { return sell ? Side::Sell : Side::Buy; }
+    };
+    static_assert(sizeof(Meta) == 8, "Meta should stay 8 bytes");
+
     // std::unordered_map<id_t, price_t> id2price;
-    std::unordered_map<id_t, std::pair<price_t, qty_t>> id2meta; // 
-    std::map<price_t, PriceLevel> levels;        // O(log M)
-    std::priority_queue<price_t> bidHeap;        // max-heap
-    std::priority_queue<
-        price_t, std::vector<price_t>, std::greater<price_t>> askHeap; // min-heap
+    std::unordered_map<id_t, Meta> id2meta; // 
+    std::map<price_t, PriceLevel> bidLevels;     // O(log M); emptied levels are erased
+    std::map<price_t, PriceLevel> askLevels;
+
+    std::map<price_t, PriceLevel>& sideLevels(Side s) {
+        return s == Side::Buy ? bidLevels : askLevels;
+    }
 };
@@ -0,0 +1,359 @@
+#pragma once
+#include "orderbook.hpp"
+
+
+// Many OrderBooks' worth of instruments in one structure. A plain OrderBook
+// preallocates every tick's PriceLevel and reserves orders on each, which is
+// several MiB per instrument; here all books draw orders and price levels from
+// shared slabs, and a level exists only while it has orders. Each book keeps
+// only its occupancy bitmap, best indices and a page table that maps 64-tick
+// pages of its range to pages of level handles (also from a shared slab, and
+// released when empty). One global IdTable maps order id -> (book, slot), so
+// order ids are unique across the pool.
+//
+// Levels are shared by both sides and best prices are tracked as in OrderBook.
+class BookPool {
+public:
+    using book_t = uint32_t;
+
+    struct Handle {
+        book_t book;
+        idx_t slot;      // in the shared order slab; stable until the order is deleted
+    };
+
+    explicit BookPool(size_t reserveOrders = 0) {
+        orders.reserve(reserveOrders);
+    }
+
+    // Adds an empty book over [min_tick, max_tick] and returns its number.
+    book_t addBook(price_t min_tick, price_t max_tick) {
+        if (max_tick < min_tick) {
+            throw std::runtime_error("invalid tick range");
+        }
+        books.emplace_back();
+        Book &bk = books.back();
+        bk.minTick = min_tick;
+        bk.nLevels = (size_t)((long long)max_tick - min_tick + 1);
+        bk.occupied.resize(bk.nLevels);
+        bk.pageOf.assign((bk.nLevels + PAGE_SIZE - 1) / PAGE_SIZE, NIL_IDX);
+        return (book_t)(books.size() - 1);
+    }
+
+    bool newOrder(book_t b, const Order& o) {
+        if (b >= books.size() || o.qty == 0 || !inRange(books[b], o.price)) {
+            return false;
+        }
+        Book &bk = books[b];
+        size_t tick = (size_t)(o.price - bk.minTick);
+        idx_t slot = allocOrder();
+        if (!index.insert(o.id, Handle{ b, slot })) {
+            freeOrder(slot);
+            return false;
+        }
+        idx_t li = levelAt(bk, tick);
+        if (li == NIL_IDX) {
+            li = newLevel(bk, tick);
+        }
+        PoolOrder &po = orders[slot];
+        po.id = o.id;
+        po.qty = o.qty;
+        po.level = li;
+        po.side = o.side;
+        linkBack(levels[li], slot);
+        levels[li].totalVolume += o.qty;
+        levels[li].activeCount++;
+        if (o.side == Side::Buy) {
+            levels[li].buyCount++;
+        }
+        bk.liveOrders++;
+        updateBestOnInsert(bk, tick, o.side);
+        return true;
+    }
+
+    bool amendOrder(id_t id, qty_t newQty) {
+        const Handle* h = index.find(id);
+        if (!h) {
+            return false;
+        }
+        if (newQty == 0) {
+            return deleteOrder(id);
+        }
+        PoolOrder &po = orders[h->slot];
+        PoolLevel &pl = levels[po.level];
+        pl.totalVolume = pl.totalVolume - po.qty + newQty;
+        po.qty = newQty;
+        return true;
+    }
+
+    bool deleteOrder(id_t id) {
+        const Handle* h = index.find(id);
+        if (!h) {
+            return false;
+        }
+        Handle e = *h;
+        Book &bk = books[e.book];
+        PoolOrder &po = orders[e.slot];
+        PoolLevel &pl = levels[po.level];
+        size_t tick = pl.tick;
+        Side side = po.side;
+        pl.totalVolume -= po.qty;
+        unlink(pl, e.slot);
+        if (side == Side::Buy) {
+            pl.buyCount--;
+        }
+        if (--pl.activeCount == 0) {
+            freeLevel(bk, tick);
+        }
+        freeOrder(e.slot);
+        index.erase(id);
+        bk.liveOrders--;
+        updateBestOnDelete(bk, tick, side);
+        return true;
+    }
+
+    PriceLevelSummary topOfBook(book_t b, Side s) const {
+        PriceLevelSummary ret;
+        const Book &bk = books[b];
+        size_t i = bestIdx(bk, s);
+        if (i != LevelBitmap::npos) {
+            const PoolLevel &pl = levels[levelAt(bk, i)];
+            ret.price = (price_t)(bk.minTick + (long long)i);
+            ret.totalQty = pl.totalVolume;
+            ret.orderCount = pl.activeCount;
+        }
+        return ret;
+    }
+
+    size_t orderCount(book_t b, price_t p) const {
+        idx_t li = levelFor(b, p);
+        return li == NIL_IDX ? 0 : levels[li].activeCount;
+    }
+
+    qty_t totalVolume(book_t b, price_t p) const {
+        idx_t li = levelFor(b, p);
+        return li == NIL_IDX ? 0 : levels[li].totalVolume;
+    }
+
+    // Book and slot of a live order, or nullptr.
+    const Handle* find(id_t id) const {
+        return index.find(id);
+    }
+
+    size_t bookCount() const {
+        return books.size();
+    }
+
+    size_t liveOrders(book_t b) const {
+        return books[b].liveOrders;
+    }
+
+    size_t totalOrders() const {
+        return index.size();
+    }
+
+    // Heap bytes held by one book's own structures (bitmap and page table);
+    // fixed by its tick range, independent of how many orders it has.
+    size_t bookBytes(book_t b) const {
+        const Book &bk = books[b];
+        return sizeof(Book) + bk.occupied.memoryBytes() + bk.pageOf.capacity() * sizeof(idx_t);
+    }
+
+    // Heap bytes held by the whole pool, by capacity: shared slabs, id index
+    // and every book.
+    size_t memoryBytes() const {
+        size_t bytes = orders.capacity() * sizeof(PoolOrder) + levels.capacity() * sizeof(PoolLevel)
+                     + pages.capacity() * sizeof(idx_t) + pageLive.capacity() * sizeof(uint32_t)
+                     + index.memoryBytes() + (books.capacity() - books.size()) * sizeof(Book);
+        for (book_t b = 0; b < books.size(); ++b) {
+            bytes += bookBytes(b);
+        }
+        return bytes;
+    }
+
+private:
+    static constexpr size_t PAGE_SIZE = 64;     // ticks per page table entry
+
+    struct PoolOrder {
+        id_t id;
+        qty_t qty;           // 0 while the slot is free
+        idx_t prev, next;    // FIFO links within the level; next doubles as the free list
+        idx_t level;
+        Side side;
+    };
+
+    struct PoolLevel {
+        qty_t totalVolume;
+        uint32_t activeCount;
+        uint32_t buyCount;   // the rest of activeCount are sells
+        idx_t head, tail;
+        uint32_t tick;       // index within its book; next free level while unused
+    };
+
+    struct Book {
+        price_t minTick = 0;
+        size_t nLevels = 0;
+        LevelBitmap occupied;
+        std::vector<idx_t> pageOf;      // per PAGE_SIZE ticks: page in `pages`, or NIL_IDX
+        size_t bestBidIdx = 0, bestAskIdx = 0;   // meaningful while that side has orders
+        size_t liveOrders = 0;
+    };
+
+    std::vector<Book> books;
+    std::vector<PoolOrder> orders;
+    std::vector<PoolLevel> levels;
+    std::vector<idx_t> pages;           // PAGE_SIZE level handles per page
+    std::vector<uint32_t> pageLive;     // live levels per page
+    idx_t freeOrders = NIL_IDX, freeLevels = NIL_IDX;
+    std::vector<idx_t> freePages;
+    IdTable<Handle> index;
+
+    bool inRange(const Book& bk, price_t p) const {
+        return p >= bk.minTick && (size_t)((long long)p - bk.minTick) < bk.nLevels;
+    }
+
+    idx_t levelFor(book_t b, price_t p) const {
+        if (b >= books.size() || !inRange(books[b], p)) {
+            return NIL_IDX;
+        }
+        return levelAt(books[b], (size_t)(p - books[b].minTick));
+    }
+
+    idx_t levelAt(const Book& bk, size_t tick) const {
+        idx_t pg = bk.pageOf[tick / PAGE_SIZE];
+        return pg == NIL_IDX ? NIL_IDX : pages[(size_t)pg * PAGE_SIZE + tick % PAGE_SIZE];
+    }
+
+    idx_t newLevel(Book& bk, size_t tick) {
+        idx_t &pg = bk.pageOf[tick / PAGE_SIZE];
+        if (pg == NIL_IDX) {
+            if (freePages.empty()) {
+                pg = (idx_t)pageLive.size();
+                pages.resize(pages.size() + PAGE_SIZE, NIL_IDX);
+                pageLive.push_back(0);
+            }
+            else {
+                pg = freePages.back();
+                freePages.pop_back();
+            }
+        }
+        idx_t li;
+        if (freeLevels != NIL_IDX) {
+            li = freeLevels;
+            freeLevels = levels[li].tick;
+        }
+        else {
+            li = (idx_t)levels.size();
+            levels.emplace_back();
+        }
+        levels[li] = PoolLevel{ 0, 0, 0, NIL_IDX, NIL_IDX, (uint32_t)tick };
+        pages[(size_t)pg * PAGE_SIZE + tick % PAGE_SIZE] = li;
+        pageLive[pg]++;
+        bk.occupied.set(tick);
+        return li;
+    }
+
+    void freeLevel(Book& bk, size_t tick) {
+        idx_t &pg = bk.pageOf[tick / PAGE_SIZE];
+        idx_t &entry = pages[(size_t)pg * PAGE_SIZE + tick % PAGE_SIZE];
+        levels[entry].tick = freeLevels;
+        freeLevels = entry;
+        entry = NIL_IDX;
+        bk.occupied.reset(tick);
+        if (--pageLive[pg] == 0) {
+            freePages.push_back(pg);
+            pg = NIL_IDX;
+        }
+    }
+
+    idx_t allocOrder() {
+        if (freeOrders != NIL_IDX) {
+            idx_t i = freeOrders;
+            freeOrders = orders[i].next;
+            return i;
+        }
+        orders.emplace_back();
+        return (idx_t)(orders.size() - 1);
+    }
+
+    void freeOrder(idx_t i) {
+        orders[i].qty = 0;
+        orders[i].next = freeOrders;
+        freeOrders = i;
+    }
+
+    void linkBack(PoolLevel& pl, idx_t i) {
+        orders[i].prev = pl.tail;
+        orders[i].next = NIL_IDX;
+        if (pl.tail != NIL_IDX) {
+            orders[pl.tail].next = i;
+        }
+        else {
+            pl.head = i;
+        }
+        pl.tail = i;
+    }
+
+    void unlink(PoolLevel& pl, idx_t i) {
+        PoolOrder &o = orders[i];
+        if (o.prev != NIL_IDX) {
+            orders[o.prev].next = o.next;
+        }
+        else {
+            pl.head = o.next;
+        }
+        if (o.next != NIL_IDX) {
+            orders[o.next].prev = o.prev;
+        }
+        else {
+            pl.tail = o.prev;
+        }
+    }
+
+    // Side-s orders resting on a book's tick.
+    uint32_t sideCount(const Book& bk, size_t tick, Side s) const {
+        idx_t li = levelAt(bk, tick);
+        if (li == NIL_IDX) {
+            return 0;
+        }
+        return s == Side::Buy ? levels[li].buyCount : levels[li].activeCount - levels[li].buyCount;
+    }
+
+    // Best tick holding side-s orders, or npos if that side is empty.
+    size_t bestIdx(const Book& bk, Side s) const {
+        size_t i = (s == Side::Buy) ? bk.bestBidIdx : bk.bestAskIdx;
+        return sideCount(bk, i, s) ? i : LevelBitmap::npos;
+    }
+
+    // Levels are shared by both sides, so a best index is kept on a level
+    // that still holds that side, as in OrderBook.
+    void updateBestOnInsert(Book& bk, size_t idx, Side s) {
+        if (s == Side::Buy) {
+            if (idx > bk.bestBidIdx || !sideCount(bk, bk.bestBidIdx, Side::Buy)) {
+                bk.bestBidIdx = idx;
+            }
+        }
+        else if (idx < bk.bestAskIdx || !sideCount(bk, bk.bestAskIdx, Side::Sell)) {
+            bk.bestAskIdx = idx;
+        }
+    }
+
+    void updateBestOnDelete(Book& bk, size_t idx, Side s) {
+        if (idx != (s == Side::Buy ? bk.bestBidIdx : bk.bestAskIdx) || sideCount(bk, idx, s)) {
+            return;
+        }
+        if (s == Side::Buy) {
+            size_t i = bk.occupied.prev(idx);
+            while (i != LevelBitmap::npos && !sideCount(bk, i, Side::Buy)) {
+                i = (i == 0) ? LevelBitmap::npos : bk.occupied.prev(i - 1);
+            }
+            bk.bestBidIdx = (i == LevelBitmap::npos) ? 0 : i;
+        }
+        else {
+            size_t i = bk.occupied.next(idx);
+            while (i != LevelBitmap::npos && !sideCount(bk, i, Side::Sell)) {
+                i = bk.occupied.next(i + 1);
+            }
+            bk.bestAskIdx = (i == LevelBitmap::npos) ? bk.nLevels - 1 : i;
+        }
+    }
+};
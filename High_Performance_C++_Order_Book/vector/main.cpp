@@ -1,8 +1,12 @@
 #include "orderbook.hpp"
+#include "recentering_orderbook.hpp"
+#include "book_pool.hpp"
+#include "../benchmark_driver.hpp"
 #include <chrono>
 #include <random>
 #include <iostream>
 #include <fstream>
+#include <deque>
 
 using clk = std::chrono::high_resolution_clock;
 
@@ -13,7 +17,26 @@ static void write_csv(const std::string& path, const std::vector<double>& v){
     for (double x : v) ofs << x << '\n';
 }
 
-void unit_tests() {
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+    if (!ok) {
+        std::cout << "FAIL: " << what << "\n";
+        failures++;
+    }
+}
+
+static Order make_order(id_t id, price_t price, qty_t qty, Side side) {
+    Order o;
+    o.id = id;
+    o.price = price;
+    o.qty = qty;
+    o.side = side;
+    return o;
+}
+
+// Returns false if any check failed.
+bool unit_tests() {
     std::cout << "==== UNIT TEST ====" << std::endl;
     OrderBook ob(0, 1000,8);
     const int N = 1000;
@@ -38,6 +61,194 @@ void unit_tests() {
     auto ta = ob.topOfBook(Side::Sell);
     std::cout << "Top Bid = " << tb.price << " qty=" << tb.totalQty << " | Top Ask = " 
          << ta.price << " qty=" << ta.totalQty << "\n";
+
+    // Time priority survives slot reuse: id 5 takes id 2's slot but queues last
+    OrderBook fifo(0, 10, 2);
+    for (id_t id = 1; id <= 5; ++id) {
+        if (id == 5) fifo.deleteOrder(2);
+        Order o;
+        o.id = id;
+        o.price = 5;
+        o.qty = 1;
+        fifo.newOrder(o);
+    }
+    std::cout << "Queue at 5 (expect 1 3 4 5):";
+    fifo.forEachOrder(5, [](const Order& o) { std::cout << " " << o.id; });
+    std::cout << "\n";
+
+    // Levels are shared by both sides: a bid on level 0 must not hide the ask at 100
+    {
+        OrderBook b(0, 1000, 2);
+        b.newOrder(make_order(1, 0, 5, Side::Buy));
+        b.newOrder(make_order(2, 100, 5, Side::Sell));
+        b.deleteOrder(1);
+        b.newOrder(make_order(3, 200, 5, Side::Sell));
+        check(b.topOfBook(Side::Sell).price == 100, "best ask after a bid leaves a shared level");
+        check(b.topOfBook(Side::Buy).orderCount == 0, "no bids left");
+        Fill fills[4];
+        MatchResult r;
+        b.match(make_order(4, 150, 5, Side::Buy), TimeInForce::GTC, fills, 4, r);
+        check(r.filled == 5 && r.rested == 0 && fills[0].makerId == 2, "buy@150 fills the ask at 100");
+        check(b.topOfBook(Side::Sell).price == 200 && b.orderCount(150) == 0, "book not crossed after match");
+    }
+
+    // Matching: price-time priority, IOC/GTC remainders, FOK all or nothing
+    {
+        OrderBook b(0, 1000, 4);
+        b.newOrder(make_order(10, 101, 5, Side::Sell));
+        b.newOrder(make_order(11, 101, 3, Side::Sell));
+        b.newOrder(make_order(12, 102, 4, Side::Sell));
+        Fill fills[8];
+        MatchResult r;
+        b.match(make_order(20, 101, 7, Side::Buy), TimeInForce::IOC, fills, 8, r);
+        check(r.fillCount == 2 && fills[0].makerId == 10 && fills[0].makerDone
+              && fills[1].makerId == 11 && fills[1].qty == 2 && !fills[1].makerDone, "IOC fills oldest first");
+        check(r.filled == 7 && r.cancelled == 0 && !b.contains(10) && b.totalVolume(101) == 1, "IOC leaves partial maker");
+
+        b.match(make_order(21, 101, 10, Side::Buy), TimeInForce::GTC, fills, 8, r);
+        check(r.filled == 1 && r.rested == 9 && r.handle && b.contains(21), "GTC rests its remainder");
+        check(b.topOfBook(Side::Buy).price == 101 && b.topOfBook(Side::Sell).price == 102, "GTC rest is the best bid");
+
+        b.match(make_order(22, 101, 3, Side::Buy), TimeInForce::IOC, fills, 8, r);
+        check(r.fillCount == 0 && r.cancelled == 3 && !b.contains(22), "IOC with nothing crossing cancels");
+
+        b.match(make_order(23, 100, 20, Side::Sell), TimeInForce::FOK, fills, 8, r);
+        check(r.fillCount == 0 && r.cancelled == 20 && b.totalVolume(101) == 9, "FOK short of quantity does nothing");
+        b.match(make_order(24, 100, 9, Side::Sell), TimeInForce::FOK, fills, 8, r);
+        check(r.filled == 9 && !b.contains(21) && b.topOfBook(Side::Buy).orderCount == 0, "FOK fills completely");
+    }
+
+    // Bulk cancels leave nothing of that side resting, wherever the best indices sit
+    {
+        OrderBook b(0, 1000, 2);
+        b.newOrder(make_order(1, 0, 5, Side::Buy));
+        b.newOrder(make_order(2, 100, 5, Side::Sell));
+        b.deleteOrder(1);
+        b.newOrder(make_order(3, 200, 5, Side::Sell));
+        check(b.cancelSide(Side::Sell) == 2, "cancelSide(Sell) counts both asks");
+        check(b.orderCount(100) == 0 && b.orderCount(200) == 0 && b.totalOrders() == 0, "cancelSide(Sell) leaves no ask");
+        check(b.topOfBook(Side::Sell).orderCount == 0, "no best ask after cancelSide(Sell)");
+
+        // Both sides on overlapping prices, so levels are mixed and the book crossed
+        id_t id = 10;
+        for (price_t p = 0; p <= 1000; p += 7) {
+            b.newOrder(make_order(id++, p, 1, Side::Buy));
+            b.newOrder(make_order(id++, p, 1, Side::Sell));
+        }
+        size_t buys = 0, sells = 0, inRange = 0;
+        for (price_t p = 0; p <= 1000; ++p) {
+            b.forEachOrder(p, [&](const Order& o) {
+                (o.side == Side::Buy ? buys : sells)++;
+                inRange += (o.side == Side::Buy && p >= 300 && p <= 600);
+            });
+        }
+        check(b.cancelRange(Side::Buy, 300, 600) == inRange, "cancelRange count");
+        size_t left = 0;
+        for (price_t p = 300; p <= 600; ++p) {
+            b.forEachOrder(p, [&](const Order& o) { left += o.side == Side::Buy; });
+        }
+        check(left == 0 && b.totalOrders() == buys + sells - inRange, "cancelRange leaves no bid in range, sells intact");
+        check(b.cancelSide(Side::Buy) == buys - inRange && b.topOfBook(Side::Buy).orderCount == 0, "cancelSide(Buy) leaves no bid");
+        check(b.totalOrders() == sells && b.topOfBook(Side::Sell).price == 0, "asks untouched by bid cancels");
+        check(b.cancelAll() == sells && b.totalOrders() == 0 && b.topOfBook(Side::Sell).orderCount == 0, "cancelAll leaves nothing");
+        check(static_cast<bool>(b.newOrder(make_order(1, 500, 1, Side::Buy))) && b.topOfBook(Side::Buy).price == 500, "book usable after cancelAll");
+    }
+
+    // IdTable paging: window advance, retiring survivors, ids behind or far ahead
+    {
+        using Table = IdTable<int>;
+        const id_t page = Table::PAGE_SIZE;
+        Table t;
+        t.insert(1, 1);
+        t.insert((Table::MAX_PAGES + 10) * page, 2);      // retires every page in the window
+        check(t.find(1) && *t.find(1) == 1 && t.find((Table::MAX_PAGES + 10) * page)
+              && *t.find((Table::MAX_PAGES + 10) * page) == 2 && t.size() == 2, "jump past a one-page window");
+        check(t.insert((Table::MAX_PAGES + 10) * page + 1, 3) && !t.insert(1, 4), "insert after the jump, no duplicates");
+        check(t.erase(1) && t.erase((Table::MAX_PAGES + 10) * page) && !t.erase(1) && t.size() == 1, "erase after the jump");
+
+        Table u;
+        u.insert(1, 1);
+        u.insert(page + 1, 2);
+        u.insert(2 * page + 1, 3);
+        u.insert((Table::MAX_PAGES + 1) * page, 4);       // retires the first two pages
+        bool all = true;
+        for (id_t id : { id_t(1), page + 1, 2 * page + 1, (Table::MAX_PAGES + 1) * page }) {
+            all = all && u.find(id);
+        }
+        check(all && u.size() == 4, "survivors of retired pages stay findable");
+        check(u.insert(5, 5) && u.find(5) && *u.find(5) == 5, "id behind the window goes to the fallback");
+        check(u.insert(id_t(3) * Table::MAX_PAGES * page, 6) && u.find(id_t(3) * Table::MAX_PAGES * page), "id far ahead goes to the fallback");
+        check(u.erase(5) && u.erase(1) && !u.find(5) && u.size() == 4, "fallback erase");
+
+        Table v;                                           // ids jump to a new range once the old ones are gone
+        for (id_t id = 1; id <= 1000; ++id) {
+            v.insert(id, 1);
+        }
+        for (id_t id = 1; id <= 1000; ++id) {
+            v.erase(id);
+        }
+        const id_t jump = id_t(1) << 40, n = 100000;
+        bool found = true;
+        for (id_t id = jump; id < jump + n; ++id) {
+            v.insert(id, 2);
+        }
+        for (id_t id = jump; id < jump + n; ++id) {
+            found = found && v.find(id) && *v.find(id) == 2;
+        }
+        check(found && v.size() == n && v.memoryBytes() < n * 16, "window re-bases after a jump, ids stay in direct pages");
+    }
+
+    // Order handles: stale once their order is gone, in step with the id API
+    {
+        OrderBook b(0, 1000, 2);
+        OrderHandle h1 = b.newOrder(make_order(1, 500, 10, Side::Buy));
+        check(h1 && b.isLive(h1) && !b.newOrder(make_order(1, 501, 1, Side::Buy)) && !b.newOrder(make_order(2, 500, 0, Side::Buy)),
+              "handle issued, rejects get an empty handle");
+        check(b.amend(h1, 7) && b.totalVolume(500) == 7 && b.amendOrder(1, 9) && b.totalVolume(500) == 9, "amend by handle and by id agree");
+        check(b.remove(h1) && !b.contains(1) && !b.deleteOrder(1) && !b.isLive(h1), "remove by handle drops the id");
+
+        OrderHandle h2 = b.newOrder(make_order(2, 500, 3, Side::Buy));   // reuses h1's slot
+        check(h2.slot == h1.slot && h2.gen != h1.gen, "slot reused with a new generation");
+        check(!b.amend(h1, 5) && !b.remove(h1) && b.totalVolume(500) == 3 && b.contains(2), "stale handle rejected after slot reuse");
+        check(b.deleteOrder(2) && !b.isLive(h2) && !b.remove(h2), "delete by id invalidates the handle");
+
+        OrderHandle h3 = b.newOrder(make_order(3, 600, 4, Side::Sell));
+        Fill fills[2];
+        MatchResult r;
+        b.match(make_order(4, 600, 4, Side::Buy), TimeInForce::IOC, fills, 2, r);
+        check(r.filled == 4 && !b.isLive(h3) && !b.amend(h3, 1), "filled maker's handle is stale");
+
+        OrderHandle h5 = b.newOrder(make_order(5, 100, 1, Side::Buy));
+        OrderHandle h6 = b.newOrder(make_order(6, 900, 1, Side::Sell));
+        size_t evicted = 0;
+        b.shiftWindow(50, [&](const Order&) { evicted++; });               // now 50..1050
+        check(b.isLive(h5) && b.isLive(h6) && evicted == 0, "handles survive a window shift");
+        b.shiftWindow(200, [&](const Order&) { evicted++; });              // 100 falls off
+        check(evicted == 1 && !b.isLive(h5) && !b.contains(5) && b.amend(h6, 2) && b.totalVolume(900) == 2,
+              "evicted order's handle is stale, kept one still works");
+
+        b.clear();
+        OrderHandle h7 = b.newOrder(make_order(7, 900, 1, Side::Sell));    // same level and slot as h6
+        check(!b.isLive(h6) && b.isLive(h7) && h7.slot == h6.slot, "generations survive clear()");
+    }
+
+    // BookPool keeps per-side bests on its shared levels too
+    {
+        BookPool pool;
+        BookPool::book_t b = pool.addBook(0, 1000);
+        pool.newOrder(b, make_order(1, 0, 5, Side::Buy));
+        pool.newOrder(b, make_order(2, 100, 7, Side::Sell));
+        pool.deleteOrder(1);
+        pool.newOrder(b, make_order(3, 200, 9, Side::Sell));
+        check(pool.topOfBook(b, Side::Sell).price == 100 && pool.topOfBook(b, Side::Sell).totalQty == 7, "pool best ask after bid delete");
+        check(pool.topOfBook(b, Side::Buy).orderCount == 0, "pool bid side empty");
+        pool.newOrder(b, make_order(4, 100, 2, Side::Buy));                  // crossed, shares the ask level
+        pool.deleteOrder(2);
+        check(pool.topOfBook(b, Side::Sell).price == 200 && pool.topOfBook(b, Side::Buy).price == 100, "pool bests skip the other side's orders");
+    }
+
+    std::cout << "Checks failed: " << failures << "\n";
+    return failures == 0;
 }
 
 void benchmark_run(size_t N = 1'000'000) {
@@ -206,12 +417,642 @@ void benchmark_run(size_t N = 1'000'000) {
          << "99th: " << latencies[(int)(0.99 * latencies.size())] << " ns\n";
 }
 
-int main() {
+// Wide book (5000 ticks) with only a handful of live orders, so most deletes
+// remove the best level and the next one is far away.
+void benchmark_sparse_delete(size_t N = 1'000'000, size_t liveOrders = 32) {
+    std::cout << "\n==== SPARSE DELETE (" << N << " deletes, " << liveOrders << " live orders, 5000 ticks) ====\n";
+    OrderBook ob(0, 5000, 8);
+    std::uniform_int_distribution<int> qty(1, 500);
+    std::uniform_int_distribution<int> price(0, 5000);
+    std::uniform_int_distribution<int> side(0, 1);
+
+    id_t nextId = 1;
+    std::vector<id_t> live;
+    auto insert = [&]() {
+        Order o;
+        o.id = nextId++;
+        o.price = (price_t)price(rng);
+        o.qty = (qty_t)qty(rng);
+        o.side = side(rng) ? Side::Buy : Side::Sell;
+        if (ob.newOrder(o)) live.push_back(o.id);
+    };
+    while (live.size() < liveOrders) insert();
+
+    std::vector<double> latencies;
+    latencies.reserve(N);
+    for (size_t i = 0; i < N; ++i) {
+        size_t pos = rng() % live.size();
+        auto t0 = clk::now();
+        ob.deleteOrder(live[pos]);
+        auto t1 = clk::now();
+        latencies.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count());
+        std::swap(live[pos], live.back());
+        live.pop_back();
+        insert();
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << "Sparse Delete: ";
+    std::cout << "Median: " << latencies[latencies.size()/2] << " " 
+         << "Min: " << latencies[0] << " " 
+         << "Max: " << latencies.back() << " "
+         << "90th: " << latencies[(int)(0.9 * latencies.size())] << " "
+         << "99th: " << latencies[(int)(0.99 * latencies.size())] << " ns\n";
+}
+
+// Drifting market: the mid random-walks away from where the book was built.
+// Most orders rest within 32 ticks of the touch, 5% far away. Inserts and
+// deletes are balanced (40/20/40 insert/amend/delete, deletes hit the oldest
+// live order) so the book keeps a steady size, as through a session.
+// Compares a fixed 5000-tick window (rejects what falls outside) with a
+// 512-tick RecenteringOrderBook on the same event stream.
+void benchmark_drift(size_t N = 1'000'000) {
+    std::cout << "\n==== DRIFTING MID (" << N << " events) ====\n";
+    struct Event { int type; Order o; };
+    const price_t mid0 = 100000;
+    std::vector<Event> events;
+    events.reserve(N);
+    std::deque<id_t> live;
+    long long mid = mid0;
+    id_t nextId = 1;
+    for (size_t i = 0; i < N; ++i) {
+        if (i % 2 == 0) mid += (long long)(rng() % 3) - 1;
+        Event e;
+        double u = (rng() % 1000) / 1000.0;
+        if (live.size() < 5000 || u < 0.40) {
+            e.type = 0;
+            e.o.id = nextId++;
+            e.o.side = (rng() % 2) ? Side::Buy : Side::Sell;
+            price_t off = (rng() % 20 == 0) ? (price_t)(500 + rng() % 4500) : (price_t)(rng() % 32);
+            e.o.price = (price_t)(e.o.side == Side::Buy ? mid - 1 - off : mid + 1 + off);
+            e.o.qty = (qty_t)(rng() % 500 + 1);
+            live.push_back(e.o.id);
+        }
+        else if (u < 0.60) {
+            e.type = 1;
+            e.o.id = live[rng() % live.size()];
+            e.o.qty = (qty_t)(rng() % 500 + 1);
+        }
+        else {
+            e.type = 2;
+            e.o.id = live.front();
+            live.pop_front();
+        }
+        events.push_back(e);
+    }
+    std::cout << "Mid moved " << (mid - mid0) << " ticks\n";
+
+    auto run = [&](const char* name, auto& ob) {
+        std::vector<double> latencies;
+        latencies.reserve(N);
+        size_t rejected = 0;
+        for (const Event& e : events) {
+            auto t0 = clk::now();
+            bool ok = e.type == 0 ? static_cast<bool>(ob.newOrder(e.o))
+                    : e.type == 1 ? ob.amendOrder(e.o.id, e.o.qty)
+                    : ob.deleteOrder(e.o.id);
+            auto t1 = clk::now();
+            latencies.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count());
+            rejected += (e.type == 0 && !ok);
+        }
+        double total = 0;
+        for (double x : latencies) total += x;
+        std::sort(latencies.begin(), latencies.end());
+        std::cout << name << ": " << (1e3 * N / total) << " Mops/s "
+             << "Median: " << latencies[latencies.size()/2] << " "
+             << "99th: " << latencies[(int)(0.99 * latencies.size())] << " ns, "
+             << "rejected inserts: " << rejected << ", resting: " << ob.totalOrders() << "\n";
+    };
+
+    OrderBook fixed(mid0 - 2500, mid0 + 2500, 8);
+    run("Fixed 5000-tick window", fixed);
+    RecenteringOrderBook moving(mid0, 256, 8);
+    run("Recentering 512-tick window", moving);
+    std::cout << "Recenters: " << moving.recenterCount() << ", parked at end: " << moving.parkedOrders() << "\n";
+}
+
+// L2 publication cost per event on a 5000-tick book with 100k resting orders:
+// full-depth snapshots of both sides after every event, depth-10 snapshots,
+// and incremental level deltas flushed every event or every 100 events.
+void benchmark_depth(size_t N = 200'000) {
+    std::cout << "\n==== L2 DEPTH (" << N << " events) ====\n";
+    struct Event { int type; Order o; };
+    std::uniform_int_distribution<int> qty(1, 500);
+    std::uniform_int_distribution<int> price(0, 5000);
+    std::vector<Order> initial;
+    std::vector<Event> events;
+    std::vector<id_t> live;
+    id_t nextId = 1;
+    auto makeOrder = [&]() {
+        Order o;
+        o.id = nextId++;
+        o.price = (price_t)price(rng);
+        o.qty = (qty_t)qty(rng);
+        o.side = (rng() % 2) ? Side::Buy : Side::Sell;
+        live.push_back(o.id);
+        return o;
+    };
+    for (int i = 0; i < 100000; ++i) initial.push_back(makeOrder());
+    for (size_t i = 0; i < N; ++i) {
+        Event e;
+        double u = (rng() % 100) / 100.0;
+        if (u < 0.45) {
+            e.type = 0;
+            e.o = makeOrder();
+        }
+        else if (u < 0.80) {
+            e.type = 1;
+            e.o.id = live[rng() % live.size()];
+            e.o.qty = (qty_t)qty(rng);
+        }
+        else {
+            e.type = 2;
+            size_t pos = rng() % live.size();
+            e.o.id = live[pos];
+            std::swap(live[pos], live.back());
+            live.pop_back();
+        }
+        events.push_back(e);
+    }
+
+    std::vector<PriceLevelSummary> levelsBuf(5001);
+    std::vector<LevelDelta> deltas;
+    deltas.reserve(5001);
+    auto run = [&](const char* name, bool useDeltas, size_t depthLevels, size_t batch) {
+        OrderBook ob(0, 5000, 8);
+        for (const Order& o : initial) ob.newOrder(o);
+        ob.enableDeltas(useDeltas);
+        size_t bytes = 0;
+        auto t0 = clk::now();
+        for (size_t i = 0; i < N; ++i) {
+            const Event& e = events[i];
+            if (e.type == 0) ob.newOrder(e.o);
+            else if (e.type == 1) ob.amendOrder(e.o.id, e.o.qty);
+            else ob.deleteOrder(e.o.id);
+            if ((i + 1) % batch) continue;
+            if (useDeltas) {
+                ob.flushDeltas(deltas);
+                bytes += deltas.size() * sizeof(LevelDelta);
+            }
+            else {
+                size_t n = ob.depth(Side::Buy, levelsBuf.data(), depthLevels);
+                n += ob.depth(Side::Sell, levelsBuf.data(), depthLevels);
+                bytes += n * sizeof(PriceLevelSummary);
+            }
+        }
+        auto t1 = clk::now();
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        std::cout << name << ": " << ns / N << " ns/event, " << (double)bytes / N << " bytes/event\n";
+    };
+    run("Full depth per event", false, 5001, 1);
+    run("Depth 10 per event", false, 10, 1);
+    run("Deltas per event", true, 0, 1);
+    run("Deltas per 100 events", true, 0, 100);
+}
+
+// Memory and op rates at a given number of live orders, for whichever order
+// layout this binary was built with (-DORDERBOOK_PACKED_ORDERS or not).
+// Amends and deletes hit distinct ids spread over the whole book.
+void benchmark_layout(size_t liveOrders, size_t ops = 1'000'000) {
+#ifdef ORDERBOOK_PACKED_ORDERS
+    const char* layout = "packed 16B + cold 12B";
+#else
+    const char* layout = "aligned 64B";
+#endif
+    std::cout << "\n==== ORDER LAYOUT (" << layout << ", " << liveOrders << " live orders) ====\n";
+    std::uniform_int_distribution<int> qty(1, 500);
+    std::uniform_int_distribution<int> price(0, 5000);
+    std::vector<price_t> prices(liveOrders);
+    std::vector<qty_t> qtys(liveOrders);
+    for (size_t i = 0; i < liveOrders; ++i) {
+        prices[i] = (price_t)price(rng);
+        qtys[i] = (qty_t)qty(rng);
+    }
+    ops = std::min(ops, liveOrders);
+    auto spreadId = [&](size_t k) {
+        return (id_t)((k * 1000003ull) % liveOrders + 1);
+    };
+    auto rate = [](size_t n, clk::time_point t0, clk::time_point t1) {
+        return n / std::chrono::duration<double, std::micro>(t1 - t0).count();
+    };
+
+    OrderBook ob(0, 5000, 8);
+    Order o;
+    auto t0 = clk::now();
+    for (size_t i = 0; i < liveOrders; ++i) {
+        o.id = i + 1;
+        o.price = prices[i];
+        o.qty = qtys[i];
+        o.side = (prices[i] & 1) ? Side::Buy : Side::Sell;
+        ob.newOrder(o);
+    }
+    auto t1 = clk::now();
+    size_t bytes = ob.memoryBytes();
+    auto t2 = clk::now();
+    for (size_t k = 0; k < ops; ++k) {
+        ob.amendOrder(spreadId(k), qtys[k] + 1);
+    }
+    auto t3 = clk::now();
+    for (size_t k = 0; k < ops; ++k) {
+        ob.deleteOrder(spreadId(k));
+    }
+    auto t4 = clk::now();
+
+    std::cout << "Memory: " << bytes / (1024.0 * 1024.0) << " MiB ("
+              << (double)bytes / liveOrders << " B/order)\n";
+    std::cout << "Insert Rate: " << rate(liveOrders, t0, t1) << " Mops/s\n";
+    std::cout << "Amend Rate: " << rate(ops, t2, t3) << " Mops/s\n";
+    std::cout << "Delete Rate: " << rate(ops, t3, t4) << " Mops/s\n";
+}
+
+// Aggressive buys that sweep 1..50 ask levels of 4 resting orders each, over
+// a background of bids. The book is refilled between sweeps, outside the
+// timed region. GTC asks for 5 more than is resting, so its remainder rests.
+void benchmark_sweep(size_t reps = 20'000) {
+    std::cout << "\n==== MATCHING SWEEP (" << reps << " sweeps per depth) ====\n";
+    const price_t bestAsk = 2500;
+    const size_t perLevel = 4;
+    const qty_t makerQty = 10;
+    std::vector<Fill> fills(50 * perLevel);
+    OrderBook ob(0, 5000, 8);
+    Order o;
+    id_t nextId = 1;
+    for (price_t p = 1000; p < bestAsk; ++p) {
+        o.id = nextId++;
+        o.price = p;
+        o.qty = 100;
+        o.side = Side::Buy;
+        ob.newOrder(o);
+    }
+    const id_t firstMaker = nextId;
+    for (size_t depth : {1, 2, 5, 10, 20, 50}) {
+        const char* names[] = { "GTC", "IOC", "FOK" };
+        const TimeInForce tifs[] = { TimeInForce::GTC, TimeInForce::IOC, TimeInForce::FOK };
+        std::cout << "Depth " << depth << ":";
+        for (int t = 0; t < 3; ++t) {
+            double ns = 0;
+            size_t fillCount = 0;
+            for (size_t r = 0; r < reps; ++r) {
+                nextId = firstMaker;
+                for (size_t l = 0; l < depth; ++l) {
+                    for (size_t k = 0; k < perLevel; ++k) {
+                        o.id = nextId++;
+                        o.price = bestAsk + (price_t)l;
+                        o.qty = makerQty;
+                        o.side = Side::Sell;
+                        ob.newOrder(o);
+                    }
+                }
+                Order taker;
+                taker.id = nextId;
+                taker.price = bestAsk + (price_t)depth - 1;
+                taker.qty = (qty_t)(depth * perLevel * makerQty) + (tifs[t] == TimeInForce::GTC ? 5 : 0);
+                taker.side = Side::Buy;
+                MatchResult res;
+                auto t0 = clk::now();
+                ob.match(taker, tifs[t], fills.data(), fills.size(), res);
+                auto t1 = clk::now();
+                ns += std::chrono::duration<double, std::nano>(t1 - t0).count();
+                fillCount += res.fillCount;
+                if (res.rested) {
+                    ob.deleteOrder(taker.id);
+                }
+            }
+            std::cout << "  " << names[t] << " " << ns / reps << " ns/sweep, "
+                      << ns / std::max<size_t>(fillCount, 1) << " ns/fill";
+        }
+        std::cout << "\n";
+    }
+}
+
+// Aggregate rate and memory of a BookPool hosting many instruments on the
+// 0-5000 tick grid. Each symbol trades within +-50 ticks of its own mid, and
+// every event picks a symbol uniformly. Ids are global. With one symbol the
+// same events also run through a plain OrderBook for reference.
+void benchmark_pool(size_t symbols, size_t N = 2'000'000, size_t liveTarget = 1'000'000) {
+    std::cout << "\n==== BOOK POOL (" << symbols << " symbols, " << N << " events) ====\n";
+    struct Event { int type; uint32_t book; Order o; };
+    std::vector<price_t> mids(symbols);
+    for (auto &m : mids) m = (price_t)(100 + rng() % 4800);
+    std::vector<std::pair<id_t, uint32_t>> live;
+    id_t nextId = 1;
+    auto makeInsert = [&]() {
+        Event e;
+        e.type = 0;
+        e.book = (uint32_t)(rng() % symbols);
+        e.o.id = nextId++;
+        e.o.price = mids[e.book] + (price_t)(rng() % 101) - 50;
+        e.o.qty = (qty_t)(rng() % 500 + 1);
+        e.o.side = (rng() % 2) ? Side::Buy : Side::Sell;
+        live.push_back({ e.o.id, e.book });
+        return e;
+    };
+    std::vector<Event> initial, events;
+    for (size_t i = 0; i < liveTarget; ++i) initial.push_back(makeInsert());
+    for (size_t i = 0; i < N; ++i) {
+        Event e;
+        size_t u = rng() % 100;
+        if (u < 40) {
+            e = makeInsert();
+        }
+        else if (u < 60) {
+            e.type = 1;
+            e.o.id = live[rng() % live.size()].first;
+            e.o.qty = (qty_t)(rng() % 500 + 1);
+        }
+        else {
+            e.type = 2;
+            size_t pos = rng() % live.size();
+            e.o.id = live[pos].first;
+            std::swap(live[pos], live.back());
+            live.pop_back();
+        }
+        events.push_back(e);
+    }
+
+    BookPool pool(liveTarget + liveTarget / 4);
+    for (size_t b = 0; b < symbols; ++b) pool.addBook(0, 5000);
+    for (const Event& e : initial) pool.newOrder(e.book, e.o);
+    auto t0 = clk::now();
+    for (const Event& e : events) {
+        if (e.type == 0) pool.newOrder(e.book, e.o);
+        else if (e.type == 1) pool.amendOrder(e.o.id, e.o.qty);
+        else pool.deleteOrder(e.o.id);
+    }
+    auto t1 = clk::now();
+    size_t bytes = pool.memoryBytes();
+    std::cout << "Aggregate Rate: " << N / std::chrono::duration<double, std::micro>(t1 - t0).count() << " Mops/s\n";
+    std::cout << "Memory: " << bytes / (1024.0 * 1024.0) << " MiB for " << pool.totalOrders() << " live orders ("
+              << (double)bytes / pool.totalOrders() << " B/order, " << pool.bookBytes(0) << " B fixed per book)\n";
+
+    OrderBook one(0, 5000, 8);
+    size_t emptyBytes = one.memoryBytes();
+    if (symbols == 1) {
+        for (const Event& e : initial) one.newOrder(e.o);
+        auto t2 = clk::now();
+        for (const Event& e : events) {
+            if (e.type == 0) one.newOrder(e.o);
+            else if (e.type == 1) one.amendOrder(e.o.id, e.o.qty);
+            else one.deleteOrder(e.o.id);
+        }
+        auto t3 = clk::now();
+        std::cout << "OrderBook Rate: " << N / std::chrono::duration<double, std::micro>(t3 - t2).count() << " Mops/s\n";
+    }
+    std::cout << "Empty OrderBook per symbol: " << emptyBytes / 1024.0 << " KiB\n";
+}
+
+// Event-at-a-time calls against OrderBook::process() at several prefetch
+// distances, on a book with liveOrders resting orders (past the LLC from a
+// few million on). 45/35/20 insert/amend/delete; amends and deletes pick live
+// ids uniformly, so nearly every one misses cache. Each run starts from the
+// same prefilled book.
+void benchmark_process(size_t liveOrders, size_t N = 2'000'000) {
+    std::cout << "\n==== BATCH PROCESS (" << liveOrders << " live orders, " << N << " events) ====\n";
+    std::vector<bench::Event> initial, events;
+    std::vector<id_t> live;
+    id_t nextId = 1;
+    auto makeInsert = [&]() {
+        bench::Event e{};
+        e.type = bench::EventType::Insert;
+        e.id = nextId++;
+        e.price = (uint32_t)(rng() % 5001);
+        e.qty = (uint32_t)(rng() % 500 + 1);
+        e.buy = rng() % 2 == 0;
+        live.push_back(e.id);
+        return e;
+    };
+    for (size_t i = 0; i < liveOrders; ++i) initial.push_back(makeInsert());
+    for (size_t i = 0; i < N; ++i) {
+        size_t u = rng() % 100;
+        bench::Event e{};
+        if (u < 45) {
+            e = makeInsert();
+        }
+        else if (u < 80) {
+            e.type = bench::EventType::Amend;
+            e.id = live[rng() % live.size()];
+            e.qty = (uint32_t)(rng() % 500 + 1);
+        }
+        else {
+            e.type = bench::EventType::Delete;
+            size_t pos = rng() % live.size();
+            e.id = live[pos];
+            std::swap(live[pos], live.back());
+            live.pop_back();
+        }
+        events.push_back(e);
+    }
+
+    auto run = [&](const char* name, size_t distance, bool batch) {
+        OrderBook ob(0, 5000, 8);
+        ob.process(initial.data(), initial.size(), 0);
+        size_t ok = 0;
+        auto t0 = clk::now();
+        if (batch) {
+            ok = ob.process(events.data(), events.size(), distance);
+        }
+        else {
+            for (const bench::Event& e : events) {
+                if (e.type == bench::EventType::Insert) {
+                    Order o;
+                    o.id = e.id;
+                    o.price = (price_t)e.price;
+                    o.qty = e.qty;
+                    o.side = e.buy ? Side::Buy : Side::Sell;
+                    ok += ob.newOrder(o) ? 1 : 0;
+                }
+                else if (e.type == bench::EventType::Amend) ok += ob.amendOrder(e.id, e.qty);
+                else ok += ob.deleteOrder(e.id);
+            }
+        }
+        auto t1 = clk::now();
+        std::cout << name;
+        if (batch) std::cout << distance;
+        std::cout << ": " << N / std::chrono::duration<double, std::micro>(t1 - t0).count() << " Mops/s ("
+                  << ok << " applied)\n";
+    };
+    run("One call per event", 0, false);
+    for (size_t d : {0, 1, 2, 4, 8, 16}) {
+        run("process, distance ", d, true);
+    }
+}
+
+// Bulk cancels against one deleteOrder per id, on an uncrossed book of
+// liveOrders orders (bids on 0-2499, asks on 2500-5000). The book is rebuilt
+// before every timed run.
+void benchmark_cancel(size_t liveOrders = 1'000'000) {
+    std::cout << "\n==== BULK CANCEL (" << liveOrders << " live orders) ====\n";
+    std::vector<Order> orders(liveOrders);
+    for (size_t i = 0; i < liveOrders; ++i) {
+        Order &o = orders[i];
+        o.id = i + 1;
+        o.side = (rng() % 2) ? Side::Buy : Side::Sell;
+        o.price = (o.side == Side::Buy) ? (price_t)(rng() % 2500) : (price_t)(2500 + rng() % 2501);
+        o.qty = (qty_t)(rng() % 500 + 1);
+    }
+    auto run = [&](const char* name, Side s, price_t lo, price_t hi, bool all) {
+        std::vector<id_t> ids;
+        for (const Order& o : orders) {
+            if (all || (o.side == s && o.price >= lo && o.price <= hi)) ids.push_back(o.id);
+        }
+        double ms[2];
+        size_t n = 0;
+        for (int bulk = 0; bulk < 2; ++bulk) {
+            OrderBook ob(0, 5000, 8);
+            for (const Order& o : orders) ob.newOrder(o);
+            auto t0 = clk::now();
+            if (!bulk) {
+                for (id_t id : ids) ob.deleteOrder(id);
+            }
+            else {
+                n = all ? ob.cancelAll() : ob.cancelRange(s, lo, hi);
+            }
+            auto t1 = clk::now();
+            ms[bulk] = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        }
+        std::cout << name << " (" << n << " orders): deleteOrder per id " << ms[0] << " ms, bulk "
+                  << ms[1] << " ms (" << ms[1] * 1e6 / std::max<size_t>(n, 1) << " ns/order)\n";
+    };
+    run("cancelSide(Buy)", Side::Buy, 0, 5000, false);
+    run("cancelRange(Sell, 2500, 2599)", Side::Sell, 2500, 2599, false);
+    run("cancelAll()", Side::Buy, 0, 5000, true);
+}
+
+// Runtime band (OrderBook(0, 5000)) against the same band fixed at compile
+// time (FixedOrderBook<0, 5000>): the driver's 45/35/20 stream applied one
+// call per event, then best bid/ask plus 10 levels of depth per side after
+// every event of a second pass over an already-full book.
+template <typename Book>
+void run_band(const char* name, Book& ob, const std::vector<bench::Event>& events) {
+    auto apply = [&](const bench::Event& e) {
+        if (e.type == bench::EventType::Insert) {
+            Order o;
+            o.id = e.id;
+            o.price = (price_t)e.price;
+            o.qty = e.qty;
+            o.side = e.buy ? Side::Buy : Side::Sell;
+            ob.newOrder(o);
+        }
+        else if (e.type == bench::EventType::Amend) ob.amendOrder(e.id, e.qty);
+        else ob.deleteOrder(e.id);
+    };
+    auto t0 = clk::now();
+    for (const bench::Event& e : events) apply(e);
+    auto t1 = clk::now();
+    PriceLevelSummary buf[10];
+    uint64_t sink = 0;
+    auto t2 = clk::now();
+    for (size_t i = 0; i < events.size(); ++i) {
+        sink += ob.topOfBook(Side::Buy).price + ob.topOfBook(Side::Sell).price;
+        sink += ob.depth(Side::Buy, buf, 10) + ob.depth(Side::Sell, buf, 10);
+    }
+    auto t3 = clk::now();
+    std::cout << name << ": events " << events.size() / std::chrono::duration<double, std::micro>(t1 - t0).count()
+              << " Mops/s, top+depth " << std::chrono::duration<double, std::nano>(t3 - t2).count() / events.size()
+              << " ns (checksum " << sink << ")\n";
+}
+
+void benchmark_fixed_band(size_t N = 1'000'000) {
+    std::cout << "\n==== FIXED BAND (" << N << " events) ====\n";
+    bench::StreamConfig cfg;
+    cfg.events = N;
+    std::vector<bench::Event> events = bench::makeEventStream(cfg);
+    for (int rep = 0; rep < 2; ++rep) {
+        {
+            OrderBook ob(0, 5000, 8);
+            run_band("OrderBook(0, 5000)", ob, events);
+        }
+        {
+            auto ob = std::make_unique<FixedOrderBook<0, 5000>>(8);
+            run_band("FixedOrderBook<0, 5000>", *ob, events);
+        }
+    }
+}
+
+// Amend and delete by id against the same calls through the handles newOrder
+// returned (kept in a vector indexed by id, standing in for a gateway's own
+// order map). Both books get the same orders; ops hit distinct ids spread
+// over the book.
+void benchmark_handles(size_t liveOrders, size_t ops = 1'000'000) {
+    std::cout << "\n==== ORDER HANDLES (" << liveOrders << " live orders) ====\n";
+    std::vector<Order> orders(liveOrders);
+    for (size_t i = 0; i < liveOrders; ++i) {
+        orders[i].id = i + 1;
+        orders[i].price = (price_t)(rng() % 5001);
+        orders[i].qty = (qty_t)(rng() % 500 + 1);
+        orders[i].side = (orders[i].price & 1) ? Side::Buy : Side::Sell;
+    }
+    ops = std::min(ops, liveOrders);
+    auto spread = [&](size_t k) { return (size_t)((k * 1000003ull) % liveOrders); };
+    auto rate = [](size_t n, clk::time_point t0, clk::time_point t1) {
+        return n / std::chrono::duration<double, std::micro>(t1 - t0).count();
+    };
+    for (int byHandle = 0; byHandle < 2; ++byHandle) {
+        OrderBook ob(0, 5000, 8);
+        std::vector<OrderHandle> handles(liveOrders);
+        for (size_t i = 0; i < liveOrders; ++i) handles[i] = ob.newOrder(orders[i]);
+        auto t0 = clk::now();
+        for (size_t k = 0; k < ops; ++k) {
+            size_t i = spread(k);
+            if (byHandle) ob.amend(handles[i], orders[i].qty + 1);
+            else ob.amendOrder(orders[i].id, orders[i].qty + 1);
+        }
+        auto t1 = clk::now();
+        for (size_t k = 0; k < ops; ++k) {
+            size_t i = spread(k);
+            if (byHandle) ob.remove(handles[i]);
+            else ob.deleteOrder(orders[i].id);
+        }
+        auto t2 = clk::now();
+        std::cout << (byHandle ? "By handle" : "By id") << ": Amend Rate: " << rate(ops, t0, t1)
+                  << " Mops/s, Delete Rate: " << rate(ops, t1, t2) << " Mops/s\n";
+    }
+}
+
+// Adapter for the shared comparison driver (../benchmark_driver.hpp).
+struct ComparisonBook {
+    OrderBook ob{0, 5000, 8};
+    bool insert(const bench::Event& e) {
+        Order o;
+        o.id = e.id;
+        o.price = (price_t)e.price;
+        o.qty = (qty_t)e.qty;
+        o.side = e.buy ? Side::Buy : Side::Sell;
+        return static_cast<bool>(ob.newOrder(o));
+    }
+    bool amend(const bench::Event& e) { return ob.amendOrder(e.id, e.qty); }
+    bool remove(const bench::Event& e) { return ob.deleteOrder(e.id); }
+    uint64_t top() { return (uint64_t)ob.topOfBook(Side::Buy).price + ob.topOfBook(Side::Sell).price; }
+};
+
+// Optional argument: an event log (see ../event_log.hpp) to replay instead.
+void benchmark_compare(const std::string& logPath = "") {
+    bench::replayComparison<ComparisonBook>("vector", logPath, "../benchmark_comparison.csv");
+}
+
+int main(int argc, char** argv) {
     std::ios::sync_with_stdio(false);
     std::cin.tie(nullptr);
 
-    //unit_tests();
+    if (!unit_tests()) {
+        return 1;
+    }
     benchmark_run(1'000'000);
+    benchmark_sparse_delete();
+    benchmark_drift();
+    benchmark_depth();
+    benchmark_layout(1'000'000);
+    benchmark_layout(10'000'000);
+    benchmark_sweep();
+    benchmark_pool(1);
+    benchmark_pool(5000);
+    benchmark_process(1'000'000);
+    benchmark_process(10'000'000);
+    benchmark_cancel();
+    benchmark_fixed_band();
+    benchmark_handles(100'000);
+    benchmark_handles(10'000'000);
+    benchmark_compare(argc > 1 ? argv[1] : "");
     // OrderBook ob(0, 1000);
     // Order o;
     // for (size_t i = 0; i < 1; ++i) {
@@ -1,9 +1,12 @@
 #pragma once
 #include <cstdint>
 #include <vector>
+#include <array>
 #include <unordered_map>
 #include <stdexcept>
 #include <algorithm>
+#include <deque>
+#include <memory>
 
 
 using id_t = uint64_t;
@@ -11,6 +14,8 @@ using price_t = int32_t;
 using qty_t = uint32_t;
 using idx_t = uint32_t;
 
+constexpr idx_t NIL_IDX = static_cast<idx_t>(-1);
+
 enum class Side : uint8_t { 
     Buy = 0, 
     Sell = 1 
@@ -22,7 +27,50 @@ struct Order {
     qty_t qty;
     Side side;
     bool active;
-    Order() : id(0), price(0), qty(0), side(Side::Buy), active(false) {}
+    idx_t prev, next;   // time-priority links within the level, owned by PriceLevel
+    uint32_t gen;       // generation of the slot's current occupant, owned by PriceLevel
+    Order() : id(0), price(0), qty(0), side(Side::Buy), active(false), prev(NIL_IDX), next(NIL_IDX), gen(0) {}
+};
+
+// New state of one price level in an L2 delta stream. A level with
+// orderCount == 0 has been removed.
+struct LevelDelta {
+    price_t price;
+    qty_t totalQty;
+    uint32_t orderCount;
+};
+
+enum class TimeInForce : uint8_t {
+    GTC = 0,    // rest any remainder
+    IOC = 1,    // cancel any remainder
+    FOK = 2     // fill completely or do nothing
+};
+
+// One execution against a resting order.
+struct Fill {
+    id_t makerId;
+    price_t price;
+    qty_t qty;
+    bool makerDone;     // resting order fully filled and removed
+};
+
+// Opaque reference to one resting order, returned by newOrder(). It names the
+// level by price (so it survives shiftWindow) and the slot within it; gen is
+// unique per order within a book, so a handle to an order that has since
+// gone (deleted, filled, cancelled, its slot reused) no longer validates.
+struct OrderHandle {
+    price_t price = 0;
+    idx_t slot = NIL_IDX;
+    uint32_t gen = 0;      // 0: no order
+    explicit operator bool() const { return gen != 0; }
+};
+
+struct MatchResult {
+    size_t fillCount = 0;
+    qty_t filled = 0;
+    qty_t rested = 0;
+    qty_t cancelled = 0;
+    OrderHandle handle;    // the rested remainder, if any
 };
 
 struct PriceLevelSummary {
@@ -32,15 +80,164 @@ struct PriceLevelSummary {
     PriceLevelSummary(): price(0), totalQty(0), orderCount(0) {}
 };
 
+// Storage layout of resting orders. By default a level stores whole Orders,
+// one cache line each. Building with -DORDERBOOK_PACKED_ORDERS stores a 16-byte
+// PackedOrder instead (everything insert/amend/delete and queue walks read),
+// with the rarely read rest of the order in a parallel PackedOrderCold array.
+// Price is the level's own and is not stored at all. The id is split low/high
+// between the two, so any 64-bit id round-trips.
+#ifdef ORDERBOOK_PACKED_ORDERS
+struct PackedOrder {
+    uint32_t idLow;
+    qty_t qty;           // 0 while the slot is free (live orders never have 0)
+    idx_t prev, next;
+};
+
+struct PackedOrderCold {
+    uint32_t idHigh;
+    uint32_t gen;
+    Side side;
+};
+
+static_assert(sizeof(PackedOrder) == 16, "PackedOrder should stay 16 bytes");
+#endif
+
+// Orders live in a slab (`orders`) whose slots never move, so a slot index is
+// a stable handle for as long as the order is active. Freed slots are reused
+// through free_list; arrival order is kept separately by an intrusive FIFO
+// (head/tail plus prev/next in each slot) over the active slots only.
 struct PriceLevel {
+#ifdef ORDERBOOK_PACKED_ORDERS
+    alignas(64) std::vector<PackedOrder> orders;
+    std::vector<PackedOrderCold> cold;       // parallel to orders
+#else
     alignas(64) std::vector<Order> orders;
+#endif
     std::vector<idx_t> free_list;
     qty_t totalVolume;
-    size_t activeCount;
-    PriceLevel(): totalVolume(0), activeCount(0) {}
+    uint32_t activeCount;
+    idx_t head, tail;
+    PriceLevel(): totalVolume(0), activeCount(0), head(NIL_IDX), tail(NIL_IDX) {}
+
+    void reserve(size_t n) {
+        orders.reserve(n);
+#ifdef ORDERBOOK_PACKED_ORDERS
+        cold.reserve(n);
+#endif
+    }
+
+    // Stores o in a free slot at the back of the queue, tagged with gen, and
+    // returns the slot.
+    idx_t add(const Order& o, uint32_t gen) {
+        idx_t i = allocSlot();
+#ifdef ORDERBOOK_PACKED_ORDERS
+        orders[i].idLow = (uint32_t)o.id;
+        orders[i].qty = o.qty;
+        cold[i].idHigh = (uint32_t)(o.id >> 32);
+        cold[i].gen = gen;
+        cold[i].side = o.side;
+#else
+        orders[i] = o;
+        orders[i].active = true;
+        orders[i].gen = gen;
+#endif
+        linkBack(i);
+        return i;
+    }
+
+    bool isActive(idx_t i) const {
+#ifdef ORDERBOOK_PACKED_ORDERS
+        return i < orders.size() && orders[i].qty != 0;
+#else
+        return i < orders.size() && orders[i].active;
+#endif
+    }
+
+    qty_t qtyAt(idx_t i) const { return orders[i].qty; }
+
+    // True if slot i holds the order tagged gen.
+    bool isLive(idx_t i, uint32_t gen) const {
+#ifdef ORDERBOOK_PACKED_ORDERS
+        return isActive(i) && cold[i].gen == gen;
+#else
+        return isActive(i) && orders[i].gen == gen;
+#endif
+    }
+
+    id_t idAt(idx_t i) const {
+#ifdef ORDERBOOK_PACKED_ORDERS
+        return ((id_t)cold[i].idHigh << 32) | orders[i].idLow;
+#else
+        return orders[i].id;
+#endif
+    }
+
+    Side sideAt(idx_t i) const {
+#ifdef ORDERBOOK_PACKED_ORDERS
+        return cold[i].side;
+#else
+        return orders[i].side;
+#endif
+    }
+
+    // q must be non-zero; a zero quantity is a delete.
+    void setQty(idx_t i, qty_t q) { orders[i].qty = q; }
+
+    void freeSlot(idx_t i) {
+        if (i < orders.size()) {
+            if (isActive(i)) {
+                unlink(i);
+            }
+#ifdef ORDERBOOK_PACKED_ORDERS
+            orders[i].qty = 0;
+#else
+            orders[i].active = false;
+#endif
+            free_list.push_back(i);
+        }
+    }
+
+    // Visits active orders in time priority (oldest first). O(active).
+    // price is this level's price, which packed slots do not store.
+    template <typename Fn>
+    void forEachOrder(price_t price, Fn fn) const {
+        for (idx_t i = head; i != NIL_IDX; i = orders[i].next) {
+#ifdef ORDERBOOK_PACKED_ORDERS
+            Order o;
+            o.id = idAt(i);
+            o.price = price;
+            o.qty = orders[i].qty;
+            o.side = cold[i].side;
+            o.active = true;
+            fn(static_cast<const Order&>(o));
+#else
+            (void)price;
+            fn(orders[i]);
+#endif
+        }
+    }
+
+    // Heap bytes held by the slab, by capacity.
+    size_t memoryBytes() const {
+        size_t bytes = orders.capacity() * sizeof(orders[0]) + free_list.capacity() * sizeof(idx_t);
+#ifdef ORDERBOOK_PACKED_ORDERS
+        bytes += cold.capacity() * sizeof(PackedOrderCold);
+#endif
+        return bytes;
+    }
 
-    void reserve(size_t n) { orders.reserve(n); }
+    void clear() {
+        orders.clear();
+#ifdef ORDERBOOK_PACKED_ORDERS
+        cold.clear();
+#endif
+        free_list.clear();
+        totalVolume = 0;
+        activeCount = 0;
+        head = tail = NIL_IDX;
+    }
 
+private:
     idx_t allocSlot() {
         if (!free_list.empty()) {
             idx_t i = free_list.back();
@@ -50,141 +247,811 @@ struct PriceLevel {
         else {
             idx_t i = static_cast<idx_t>(orders.size());
             orders.emplace_back();
+#ifdef ORDERBOOK_PACKED_ORDERS
+            cold.emplace_back();
+#endif
             return i;
         }
     }
 
-    void freeSlot(idx_t i) {
-        if (i < orders.size()) {
-            orders[i].active = false;
-            free_list.push_back(i);
+    // Appends slot i (already filled in) at the back of the queue.
+    void linkBack(idx_t i) {
+        orders[i].prev = tail;
+        orders[i].next = NIL_IDX;
+        if (tail != NIL_IDX) {
+            orders[tail].next = i;
+        }
+        else {
+            head = i;
+        }
+        tail = i;
+    }
+
+    void unlink(idx_t i) {
+        auto &o = orders[i];
+        if (o.prev != NIL_IDX) {
+            orders[o.prev].next = o.next;
+        }
+        else {
+            head = o.next;
+        }
+        if (o.next != NIL_IDX) {
+            orders[o.next].prev = o.prev;
+        }
+        else {
+            tail = o.prev;
+        }
+        o.prev = o.next = NIL_IDX;
+    }
+};
+
+// Occupancy bitmap over price levels, 64-ary and layered: bit i of layer 0 is
+// set while level i has active orders, and bit w of layer k+1 is set while
+// word w of layer k is non-zero. Next/previous occupied level is one ctz/clz
+// per layer (three layers cover 262144 ticks). Layers is the word storage:
+// DynamicLayers sizes it at run time, FixedLayers<N> at compile time.
+template <typename Layers>
+class BasicLevelBitmap {
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    void resize(size_t n) {
+        layers.resize(n);
+    }
+
+    void clear() {
+        layers.clear();
+    }
+
+    void set(size_t i) {
+        for (size_t k = 0; k < layers.count(); ++k) {
+            uint64_t &word = layers.word(k, i >> 6);
+            bool wasEmpty = word == 0;
+            word |= uint64_t(1) << (i & 63);
+            if (!wasEmpty) {
+                return;
+            }
+            i >>= 6;
+        }
+    }
+
+    void reset(size_t i) {
+        for (size_t k = 0; k < layers.count(); ++k) {
+            uint64_t &word = layers.word(k, i >> 6);
+            word &= ~(uint64_t(1) << (i & 63));
+            if (word != 0) {
+                return;
+            }
+            i >>= 6;
+        }
+    }
+
+    // Lowest occupied level >= i, or npos.
+    size_t next(size_t i) const {
+        size_t k = 0;
+        for (; k < layers.count(); ++k) {
+            size_t w = i >> 6;
+            if (w >= layers.size(k)) {
+                return npos;
+            }
+            uint64_t m = layers.word(k, w) & (~uint64_t(0) << (i & 63));
+            if (m) {
+                i = (w << 6) | __builtin_ctzll(m);
+                break;
+            }
+            i = w + 1;
+        }
+        if (k == layers.count()) {
+            return npos;
+        }
+        while (k-- > 0) {
+            i = (i << 6) | __builtin_ctzll(layers.word(k, i));
+        }
+        return i;
+    }
+
+    // Highest occupied level <= i, or npos.
+    size_t prev(size_t i) const {
+        size_t k = 0;
+        for (; k < layers.count(); ++k) {
+            size_t w = i >> 6;
+            uint64_t m = layers.word(k, w) & (~uint64_t(0) >> (63 - (i & 63)));
+            if (m) {
+                i = (w << 6) | (63 - __builtin_clzll(m));
+                break;
+            }
+            if (w == 0) {
+                return npos;
+            }
+            i = w - 1;
+        }
+        if (k == layers.count()) {
+            return npos;
+        }
+        while (k-- > 0) {
+            i = (i << 6) | (63 - __builtin_clzll(layers.word(k, i)));
+        }
+        return i;
+    }
+
+    size_t memoryBytes() const {
+        return layers.memoryBytes();
+    }
+
+private:
+    Layers layers;
+};
+
+struct DynamicLayers {
+    std::vector<std::vector<uint64_t>> words;
+
+    void resize(size_t n) {
+        words.clear();
+        do {
+            n = (n + 63) / 64;
+            words.emplace_back(n, 0);
+        } while (n > 1);
+    }
+
+    void clear() {
+        for (auto &layer : words) {
+            std::fill(layer.begin(), layer.end(), 0);
+        }
+    }
+
+    size_t count() const { return words.size(); }
+    size_t size(size_t k) const { return words[k].size(); }
+    uint64_t& word(size_t k, size_t w) { return words[k][w]; }
+    uint64_t word(size_t k, size_t w) const { return words[k][w]; }
+
+    size_t memoryBytes() const {
+        size_t bytes = words.capacity() * sizeof(words[0]);
+        for (const auto &layer : words) {
+            bytes += layer.capacity() * sizeof(uint64_t);
+        }
+        return bytes;
+    }
+};
+
+// All layers of an N-level bitmap in one array, so layer count, sizes and
+// offsets are constants.
+template <size_t N>
+struct FixedLayers {
+    static constexpr size_t layerSize(size_t k) {
+        size_t n = (N + 63) / 64;
+        for (; k > 0; --k) {
+            n = (n + 63) / 64;
+        }
+        return n;
+    }
+
+    static constexpr size_t layerCount() {
+        size_t k = 1;
+        while (layerSize(k - 1) > 1) {
+            ++k;
+        }
+        return k;
+    }
+
+    static constexpr size_t offset(size_t k) {
+        size_t o = 0;
+        for (size_t j = 0; j < k; ++j) {
+            o += layerSize(j);
+        }
+        return o;
+    }
+
+    std::array<uint64_t, offset(layerCount())> words{};
+
+    void resize(size_t) {}
+    void clear() { words.fill(0); }
+
+    static constexpr size_t count() { return layerCount(); }
+    static constexpr size_t size(size_t k) { return layerSize(k); }
+    uint64_t& word(size_t k, size_t w) { return words[offset(k) + w]; }
+    uint64_t word(size_t k, size_t w) const { return words[offset(k) + w]; }
+
+    size_t memoryBytes() const { return 0; }     // inline, no heap
+};
+
+using LevelBitmap = BasicLevelBitmap<DynamicLayers>;
+
+template <size_t N>
+using FixedLevelBitmap = BasicLevelBitmap<FixedLayers<N>>;
+
+// Order id -> T for ids that mostly arrive in increasing order (exchange
+// sequence numbers). Ids in [base, base + window) index flat pages directly
+// by id - base; anything else (ids behind base, or far ahead of the window)
+// goes to a hash fallback. An entry is live only if its generation matches
+// its page's, so a page is recycled by bumping the generation instead of
+// clearing it. Empty pages at the front are released as ids advance; if the
+// window would grow past MAX_PAGES, the oldest page's survivors move to the
+// fallback.
+template <typename T>
+class IdTable {
+public:
+    static constexpr size_t PAGE_BITS = 12;
+    static constexpr size_t PAGE_SIZE = size_t(1) << PAGE_BITS;
+    static constexpr size_t MAX_PAGES = 4096;    // 16M ids of direct range
+
+    T* find(id_t id) {
+        if (id >= base) {
+            uint64_t rel = id - base;
+            size_t pg = rel >> PAGE_BITS;
+            if (pg < window.size() && window[pg]) {
+                Page &p = *window[pg];
+                Entry &e = p.entries[rel & (PAGE_SIZE - 1)];
+                if (e.gen == p.gen) {
+                    return &e.value;
+                }
+            }
+        }
+        if (fallback.empty()) {
+            return nullptr;
+        }
+        auto it = fallback.find(id);
+        return it == fallback.end() ? nullptr : &it->second;
+    }
+
+    const T* find(id_t id) const {
+        return const_cast<IdTable*>(this)->find(id);
+    }
+
+    bool contains(id_t id) const {
+        return find(id) != nullptr;
+    }
+
+    // Requests the cache line find(id) will read, without waiting for it.
+    // Ids outside the direct window are not prefetched.
+    void prefetch(id_t id) const {
+        if (id >= base) {
+            size_t pg = (id - base) >> PAGE_BITS;
+            if (pg < window.size() && window[pg]) {
+                __builtin_prefetch(&window[pg]->entries[(id - base) & (PAGE_SIZE - 1)]);
+            }
+        }
+    }
+
+    // Returns false if id is already present.
+    bool insert(id_t id, const T& value) {
+        if (find(id)) {
+            return false;
+        }
+        if (count == fallback.size() && !window.empty()
+            && (id < base || id - base >= MAX_PAGES * PAGE_SIZE)) {
+            // No live ids in the window and id is outside it: start over at
+            // id's page rather than sending this and later ids to the fallback.
+            recycleWindow();
+        }
+        if (window.empty()) {
+            base = id & ~uint64_t(PAGE_SIZE - 1);
+        }
+        if (id >= base) {
+            size_t pg = (id - base) >> PAGE_BITS;
+            if (pg >= MAX_PAGES && pg < 2 * MAX_PAGES) {
+                // Advancing past the window: retire the oldest pages. If that
+                // empties the window, restart it at id's page.
+                while (pg >= MAX_PAGES && !window.empty()) {
+                    retireFront();
+                    pg--;
+                }
+                if (window.empty()) {
+                    base = id & ~uint64_t(PAGE_SIZE - 1);
+                    pg = 0;
+                }
+            }
+            if (pg < MAX_PAGES) {
+                if (pg >= window.size()) {
+                    window.resize(pg + 1);
+                }
+                if (!window[pg]) {
+                    window[pg] = newPage();
+                }
+                Page &p = *window[pg];
+                Entry &e = p.entries[(id - base) & (PAGE_SIZE - 1)];
+                e.value = value;
+                e.gen = p.gen;
+                p.live++;
+                count++;
+                return true;
+            }
+        }
+        fallback.emplace(id, value);
+        count++;
+        return true;
+    }
+
+    bool erase(id_t id) {
+        if (id >= base) {
+            uint64_t rel = id - base;
+            size_t pg = rel >> PAGE_BITS;
+            if (pg < window.size() && window[pg]) {
+                Page &p = *window[pg];
+                Entry &e = p.entries[rel & (PAGE_SIZE - 1)];
+                if (e.gen == p.gen) {
+                    e.gen = 0;
+                    p.live--;
+                    count--;
+                    releaseEmptyFront();
+                    return true;
+                }
+            }
+        }
+        if (fallback.erase(id)) {
+            count--;
+            return true;
+        }
+        return false;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    // Heap bytes held: pages (in use and spare), the page deque and an
+    // estimate for the fallback's nodes and buckets.
+    size_t memoryBytes() const {
+        size_t pages = spare.size();
+        for (const auto &p : window) {
+            pages += p ? 1 : 0;
+        }
+        return pages * sizeof(Page) + window.size() * sizeof(window[0])
+             + fallback.size() * (sizeof(typename decltype(fallback)::value_type) + sizeof(void*))
+             + fallback.bucket_count() * sizeof(void*);
+    }
+
+    void clear() {
+        recycleWindow();
+        fallback.clear();
+        base = 0;
+        count = 0;
+    }
+
+private:
+    struct Entry {
+        T value;
+        uint32_t gen;      // live iff equal to the page's gen; 0 is never live
+    };
+
+    struct Page {
+        uint32_t gen = 0;
+        size_t live = 0;
+        Entry entries[PAGE_SIZE] = {};
+    };
+
+    std::deque<std::unique_ptr<Page>> window;    // window[k] covers base + k*PAGE_SIZE
+    std::vector<std::unique_ptr<Page>> spare;
+    std::unordered_map<id_t, T> fallback;
+    uint64_t base = 0;
+    size_t count = 0;
+
+    std::unique_ptr<Page> newPage() {
+        std::unique_ptr<Page> p;
+        if (spare.empty()) {
+            p.reset(new Page());
+        }
+        else {
+            p = std::move(spare.back());
+            spare.pop_back();
+        }
+        p->gen++;
+        p->live = 0;
+        return p;
+    }
+
+    void recycleWindow() {
+        for (auto &p : window) {
+            if (p) {
+                spare.push_back(std::move(p));
+            }
+        }
+        window.clear();
+    }
+
+    void popFront() {
+        if (window.front()) {
+            spare.push_back(std::move(window.front()));
+        }
+        window.pop_front();
+        base += PAGE_SIZE;
+    }
+
+    // Moves the oldest page's live entries to the fallback, then drops it.
+    void retireFront() {
+        if (window.front()) {
+            Page &p = *window.front();
+            for (size_t i = 0; i < PAGE_SIZE && p.live; ++i) {
+                if (p.entries[i].gen == p.gen) {
+                    fallback.emplace(base + i, p.entries[i].value);
+                    p.live--;
+                }
+            }
+        }
+        popFront();
+    }
+
+    // Front pages with no live ids are behind the newest page, so (with
+    // increasing ids) nothing new will land on them.
+    void releaseEmptyFront() {
+        while (window.size() > 1 && (!window.front() || window.front()->live == 0)) {
+            popFront();
+        }
+    }
+};
+
+
+// Tick band of a BasicOrderBook. DynamicBand is set at run time and can be
+// moved by shiftWindow(); FixedBand fixes it at compile time, so the range
+// math in inRange/idxForPrice/idxToPrice folds to constants and the levels
+// and occupancy bitmap are std::arrays inside the book.
+struct DynamicBand {
+    static constexpr bool fixed = false;
+    using Levels = std::vector<PriceLevel>;
+    using Bitmap = LevelBitmap;
+    using Counts = std::vector<uint32_t>;
+
+    price_t minTick, maxTick;
+    size_t nLevels;
+
+    DynamicBand(price_t min_tick, price_t max_tick) : minTick(min_tick), maxTick(max_tick) {
+        if (maxTick < minTick) {
+            throw std::runtime_error("invalid tick range");
         }
+        nLevels = static_cast<size_t>(maxTick - minTick + 1);
     }
 };
 
+template <price_t MinTick, price_t MaxTick>
+struct FixedBand {
+    static_assert(MinTick <= MaxTick, "invalid tick range");
+    static constexpr bool fixed = true;
+    static constexpr price_t minTick = MinTick;
+    static constexpr price_t maxTick = MaxTick;
+    static constexpr size_t nLevels = static_cast<size_t>((long long)MaxTick - MinTick + 1);
+    using Levels = std::array<PriceLevel, nLevels>;
+    using Bitmap = FixedLevelBitmap<nLevels>;
+    using Counts = std::array<uint32_t, nLevels>;
+};
 
-class OrderBook {
+// OrderBook (below) is the runtime-band book. FixedOrderBook<Min, Max> holds
+// its levels inline (about 64 bytes per tick), so allocate it on the heap.
+template <typename Band>
+class BasicOrderBook {
 public:
+    // idx is the order's slot in its level's slab; it stays valid until the
+    // order is deleted.
     struct Meta {
         price_t price;
         idx_t idx;
         Side side;
     };
 
-    OrderBook(price_t min_tick, price_t max_tick, size_t reserve_per_level = 8)
-        : minTick(min_tick), maxTick(max_tick)
+    // Dynamic bands only.
+    BasicOrderBook(price_t min_tick, price_t max_tick, size_t reserve_per_level = 8)
+        : band(min_tick, max_tick)
     {
-        if (maxTick < minTick) {
-            throw std::runtime_error("invalid tick range");
-        }
-        nLevels = static_cast<size_t>(maxTick - minTick + 1);
-        levels.resize(nLevels);
-        for (auto &pl : levels) {
-            pl.reserve(reserve_per_level);
-        }
-        idMap.reserve(1<<20);
+        static_assert(!Band::fixed, "a fixed band takes its range from its template arguments");
+        init(reserve_per_level);
     }
 
-    bool newOrder(const Order& o) {
+    // Fixed bands only.
+    explicit BasicOrderBook(size_t reserve_per_level = 8) {
+        static_assert(Band::fixed, "a dynamic band needs a (min_tick, max_tick) range");
+        init(reserve_per_level);
+    }
+
+    // Returns a handle to the new order, or an empty handle if o is rejected.
+    OrderHandle newOrder(const Order& o) {
         if (o.qty == 0 || !inRange(o.price)) {
-            return false;
+            return OrderHandle();
         }
-        if (idMap.count(o.id)) {
-            return false;
+        if (idMap.contains(o.id)) {
+            return OrderHandle();
         }
 
+        if (++nextGen == 0) {
+            ++nextGen;
+        }
         auto &pl = levels[idxForPrice(o.price)];
-        idx_t id = pl.allocSlot();
-
-        pl.orders[id] = o;
-        pl.orders[id].active = true;
+        idx_t id = pl.add(o, nextGen);
         pl.totalVolume += o.qty;
-        pl.activeCount++;
+        if (pl.activeCount++ == 0) {
+            occupied.set(idxForPrice(o.price));
+        }
+        if (o.side == Side::Buy) {
+            buyCount[idxForPrice(o.price)]++;
+        }
+        touch(idxForPrice(o.price));
 
-        idMap.emplace(o.id, Meta{ o.price, id, o.side });
+        idMap.insert(o.id, Meta{ o.price, id, o.side });
         updateBestOnInsert(o.price, o.side);
-        return true;
+        return OrderHandle{ o.price, id, nextGen };
     }
 
     bool amendOrder(id_t id, qty_t newQty) {
-        auto it = idMap.find(id);
-        if (it == idMap.end()) {
+        const Meta* m = idMap.find(id);
+        if (!m) {
             return false;
         }
 
-        Meta e = it->second;
+        Meta e = *m;
         auto &pl = levels[idxForPrice(e.price)];
-        if (e.idx >= pl.orders.size() || !pl.orders[e.idx].active) {
+        if (!pl.isActive(e.idx)) {
             return false;
         }
 
-        auto &ord = pl.orders[e.idx];
         if (newQty == 0) {
             return deleteOrder(id);
         }
-        if (newQty > ord.qty) {
-            pl.totalVolume += (newQty - ord.qty);
+        qty_t oldQty = pl.qtyAt(e.idx);
+        if (newQty > oldQty) {
+            pl.totalVolume += (newQty - oldQty);
         } 
         else {
-            pl.totalVolume -= (ord.qty - newQty);
+            pl.totalVolume -= (oldQty - newQty);
         }
-        ord.qty = newQty;
+        pl.setQty(e.idx, newQty);
+        touch(idxForPrice(e.price));
         return true;
     }
 
     bool deleteOrder(id_t id) {
-        auto it = idMap.find(id);
-        if (it == idMap.end()) {
+        const Meta* m = idMap.find(id);
+        if (!m) {
             return false;
         }
 
-        Meta e = it->second;
+        Meta e = *m;
         auto &pl = levels[idxForPrice(e.price)];
-        if (e.idx >= pl.orders.size()) {
+        if (!pl.isActive(e.idx)) {
             return false;
         }
 
-        auto &ord = pl.orders[e.idx];
-        if (!ord.active) {
+        removeSlot(idxForPrice(e.price), e.idx, id, e.side);
+        return true;
+    }
+
+    // Handle-based amend and delete, for callers that keep newOrder()'s
+    // handles: the level and slot come straight from the handle, so there is
+    // no idMap lookup. A stale handle is rejected by its generation.
+    bool amend(const OrderHandle& h, qty_t newQty) {
+        if (!isLive(h)) {
             return false;
         }
+        if (newQty == 0) {
+            return remove(h);
+        }
+        size_t li = idxForPrice(h.price);
+        PriceLevel &pl = levels[li];
+        pl.totalVolume = pl.totalVolume - pl.qtyAt(h.slot) + newQty;
+        pl.setQty(h.slot, newQty);
+        touch(li);
+        return true;
+    }
 
-        pl.totalVolume -= ord.qty;
-        pl.activeCount--;
-        pl.freeSlot(e.idx);
-        idMap.erase(it);
-        updateBestOnDelete(e.price, e.side);
+    bool remove(const OrderHandle& h) {
+        if (!isLive(h)) {
+            return false;
+        }
+        size_t li = idxForPrice(h.price);
+        const PriceLevel &pl = levels[li];
+        removeSlot(li, h.slot, pl.idAt(h.slot), pl.sideAt(h.slot));
         return true;
     }
 
-    PriceLevelSummary topOfBook(Side s) const {
-        PriceLevelSummary ret;
-        if (s == Side::Buy) {
-            for (size_t i = bestBidIdx + 1; i-- > 0;) {
-                if (levels[i].activeCount) {
-                    ret.price = idxToPrice(i);
-                    ret.totalQty = levels[i].totalVolume;
-                    ret.orderCount = levels[i].activeCount;
-                    return ret;
-                }
-                if (i == 0){
-                    break;
+    bool isLive(const OrderHandle& h) const {
+        return h.gen != 0 && inRange(h.price) && levels[idxForPrice(h.price)].isLive(h.slot, h.gen);
+    }
+
+    // Aggressive limit order: sweeps opposite-side levels from the best one
+    // while they are at or better than o.price, consuming each level's queue
+    // oldest first, and writes one Fill per execution to fills. Then, by tif,
+    // the remainder rests (GTC, as newOrder) or is cancelled (IOC); FOK fills
+    // only if the whole quantity is available within maxFills executions, and
+    // otherwise does nothing. If fills fills up while o still crosses, matching
+    // stops and the remainder is cancelled even for GTC, so the book never
+    // crosses. Orders that may cross must come in through here.
+    // Returns false (and changes nothing) for the same inputs newOrder rejects.
+    bool match(const Order& o, TimeInForce tif, Fill* fills, size_t maxFills, MatchResult& result) {
+        result = MatchResult();
+        if (o.qty == 0 || !inRange(o.price) || idMap.contains(o.id)) {
+            return false;
+        }
+        if (tif == TimeInForce::FOK && !canFill(o, maxFills)) {
+            result.cancelled = o.qty;
+            return true;
+        }
+
+        const bool buy = o.side == Side::Buy;
+        const size_t limit = idxForPrice(o.price);
+        qty_t remaining = o.qty;
+        size_t li = firstOpposite(o.side);
+        while (remaining && li != LevelBitmap::npos && (buy ? li <= limit : li >= limit)) {
+            PriceLevel &pl = levels[li];
+            idx_t slot = pl.head;
+            while (remaining && slot != NIL_IDX && result.fillCount < maxFills) {
+                idx_t next = pl.orders[slot].next;
+                if (pl.sideAt(slot) != o.side) {
+                    qty_t makerQty = pl.qtyAt(slot);
+                    qty_t q = std::min(remaining, makerQty);
+                    id_t makerId = pl.idAt(slot);
+                    fills[result.fillCount++] = Fill{ makerId, idxToPrice(li), q, q == makerQty };
+                    remaining -= q;
+                    if (q == makerQty) {
+                        removeSlot(li, slot, makerId, buy ? Side::Sell : Side::Buy);
+                    }
+                    else {
+                        pl.setQty(slot, makerQty - q);
+                        pl.totalVolume -= q;
+                        touch(li);
+                    }
                 }
+                slot = next;
             }
-        } 
+            if (result.fillCount == maxFills) {
+                break;
+            }
+            li = buy ? occupied.next(li + 1) : (li == 0 ? LevelBitmap::npos : occupied.prev(li - 1));
+        }
+
+        result.filled = o.qty - remaining;
+        // Out of fill slots: rest only if nothing left on the other side crosses.
+        Order probe = o;
+        probe.qty = 1;
+        bool stillCrosses = remaining && result.fillCount == maxFills && canFill(probe, SIZE_MAX);
+        if (remaining && tif == TimeInForce::GTC && !stillCrosses) {
+            Order rest = o;
+            rest.qty = remaining;
+            result.handle = newOrder(rest);
+            result.rested = remaining;
+        }
         else {
-            for (size_t i = bestAskIdx; i < nLevels; ++i) {
-                if (levels[i].activeCount) {
-                    ret.price = idxToPrice(i);
-                    ret.totalQty = levels[i].totalVolume;
-                    ret.orderCount = levels[i].activeCount;
-                    return ret;
+            result.cancelled = remaining;
+        }
+        return true;
+    }
+
+    // Bulk cancels. Occupied levels in the range are found with the bitmap
+    // and those without side-s orders are skipped by their counts, so nothing
+    // is assumed about where the best prices sit. Each level touched is
+    // walked once to drop its ids from idMap and then cleared wholesale; the
+    // best index is searched again once at the end. Each returns the number
+    // of orders cancelled.
+    size_t cancelSide(Side s) {
+        return cancelRange(s, band.minTick, band.maxTick);
+    }
+
+    // Cancels side s orders priced in [lo, hi] (clipped to the window).
+    size_t cancelRange(Side s, price_t lo, price_t hi) {
+        lo = std::max(lo, band.minTick);
+        hi = std::min(hi, band.maxTick);
+        if (lo > hi) {
+            return 0;
+        }
+        size_t last = idxForPrice(hi);
+        size_t n = 0;
+        for (size_t li = occupied.next(idxForPrice(lo)); li != LevelBitmap::npos && li <= last; li = occupied.next(li + 1)) {
+            if (sideCount(li, s)) {
+                n += cancelLevel(li, s);
+            }
+        }
+        if (n) {
+            seekBest(s);
+        }
+        return n;
+    }
+
+    size_t cancelAll() {
+        size_t n = idMap.size();
+        clear();
+        return n;
+    }
+
+    // Applies a batch of events in order and returns how many succeeded; the
+    // book ends up exactly as if newOrder/amendOrder/deleteOrder had been
+    // called one by one. Ev is bench::Event or any type with id, price, qty,
+    // buy and a scoped-enum type with Insert/Amend/Delete (anything else is
+    // skipped). While applying event i, memory for later events is requested
+    // in three steps: the id-table entry at i + 3*distance (the level, for an
+    // insert), the level at i + 2*distance (the insert's tail slot), and the
+    // order slot at i + distance, so misses overlap instead of queueing up.
+    // distance 0 turns prefetching off.
+    template <typename Ev>
+    size_t process(const Ev* events, size_t count, size_t distance = 8) {
+        using Type = decltype(events->type);
+        size_t applied = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (distance) {
+                if (i + 3 * distance < count) {
+                    prefetchStage(events[i + 3 * distance], 0);
+                }
+                if (i + 2 * distance < count) {
+                    prefetchStage(events[i + 2 * distance], 1);
                 }
+                if (i + distance < count) {
+                    prefetchStage(events[i + distance], 2);
+                }
+            }
+            const Ev &e = events[i];
+            if (e.type == Type::Insert) {
+                Order o;
+                o.id = e.id;
+                o.price = (price_t)e.price;
+                o.qty = e.qty;
+                o.side = e.buy ? Side::Buy : Side::Sell;
+                applied += newOrder(o) ? 1 : 0;
+            }
+            else if (e.type == Type::Amend) {
+                applied += amendOrder(e.id, e.qty);
             }
+            else if (e.type == Type::Delete) {
+                applied += deleteOrder(e.id);
+            }
+        }
+        return applied;
+    }
+
+    PriceLevelSummary topOfBook(Side s) const {
+        PriceLevelSummary ret;
+        size_t i = bestIdx(s);
+        if (i != LevelBitmap::npos) {
+            ret.price = idxToPrice(i);
+            ret.totalQty = levels[i].totalVolume;
+            ret.orderCount = levels[i].activeCount;
         }
         return ret;
     }
 
+    // Copies up to n levels of one side, best first, into out and returns how
+    // many were written. Levels are shared by both sides, as in topOfBook().
+    // Each step is one bitmap search, so empty ticks cost nothing.
+    size_t depth(Side s, PriceLevelSummary* out, size_t n) const {
+        size_t count = 0;
+        size_t i = bestIdx(s);
+        while (count < n && i != LevelBitmap::npos) {
+            if (sideCount(i, s)) {
+                out[count].price = idxToPrice(i);
+                out[count].totalQty = levels[i].totalVolume;
+                out[count].orderCount = levels[i].activeCount;
+                ++count;
+            }
+            if (s == Side::Buy) {
+                i = (i == 0) ? LevelBitmap::npos : occupied.prev(i - 1);
+            }
+            else {
+                i = occupied.next(i + 1);
+            }
+        }
+        return count;
+    }
+
+    // Incremental L2. While enabled, every level an operation changes is
+    // recorded once; flushDeltas() then emits the current state of just those
+    // levels, so a batch of events costs one message per touched level rather
+    // than a full snapshot. Enabling (or disabling) drops anything pending.
+    void enableDeltas(bool on) {
+        deltasOn = on;
+        std::fill(dirty.begin(), dirty.end(), 0);
+        touched.clear();
+        carried.clear();
+        if (on) {
+            dirty.resize(band.nLevels, 0);
+        }
+    }
+
+    // Replaces out's contents with the deltas since the last flush (reusing
+    // its capacity), in the order the levels were first touched.
+    void flushDeltas(std::vector<LevelDelta>& out) {
+        out.clear();
+        out.insert(out.end(), carried.begin(), carried.end());
+        for (idx_t i : touched) {
+            out.push_back(LevelDelta{ idxToPrice(i), levels[i].totalVolume, (uint32_t)levels[i].activeCount });
+            dirty[i] = 0;
+        }
+        touched.clear();
+        carried.clear();
+    }
+
     size_t orderCount(price_t p) const {
         return inRange(p) ? levels[idxForPrice(p)].activeCount : 0;
     }
@@ -193,64 +1060,337 @@ public:
         return inRange(p) ? levels[idxForPrice(p)].totalVolume : 0;
     }
 
+    // Visits the active orders at price p, oldest first.
+    template <typename Fn>
+    void forEachOrder(price_t p, Fn fn) const {
+        if (inRange(p)) {
+            levels[idxForPrice(p)].forEachOrder(p, fn);
+        }
+    }
+
     size_t totalOrders() const { 
         return idMap.size(); 
     }
 
+    bool contains(id_t id) const {
+        return idMap.contains(id);
+    }
+
+    // Bytes held by the levels (their array, for a fixed band), their buy
+    // counts and the id index, by capacity.
+    size_t memoryBytes() const {
+        size_t bytes = levels.size() * (sizeof(PriceLevel) + sizeof(uint32_t)) + idMap.memoryBytes();
+        for (const auto &pl : levels) {
+            bytes += pl.memoryBytes();
+        }
+        return bytes;
+    }
+
+    price_t minPrice() const { return band.minTick; }
+    price_t maxPrice() const { return band.maxTick; }
+
+    // Moves the tick window to start at newMinTick, keeping its width. Levels
+    // that stay in the window are rotated into place with their orders, and
+    // Meta holds prices rather than level indices, so those orders are not
+    // touched. Orders on levels that leave the window are removed and passed
+    // to evicted(const Order&), level by level, oldest first.
+    template <typename Fn>
+    void shiftWindow(price_t newMinTick, Fn evicted) {
+        static_assert(!Band::fixed, "a fixed band cannot move");
+        long long shift = (long long)newMinTick - band.minTick;
+        if (shift == 0) {
+            return;
+        }
+        size_t k = (size_t)std::min<long long>(shift > 0 ? shift : -shift, (long long)band.nLevels);
+        size_t first = shift > 0 ? 0 : band.nLevels - k;
+        if (deltasOn) {
+            // Pending level indices are about to move: emit them as they are
+            // now, and report evicted levels as removed.
+            for (idx_t i : touched) {
+                carried.push_back(LevelDelta{ idxToPrice(i), levels[i].totalVolume, (uint32_t)levels[i].activeCount });
+                dirty[i] = 0;
+            }
+            touched.clear();
+            for (size_t i = first; i < first + k; ++i) {
+                if (levels[i].activeCount) {
+                    carried.push_back(LevelDelta{ idxToPrice(i), 0, 0 });
+                }
+            }
+        }
+        for (size_t i = first; i < first + k; ++i) {
+            levels[i].forEachOrder(idxToPrice(i), [&](const Order& o) {
+                idMap.erase(o.id);
+                evicted(o);
+            });
+            levels[i].clear();
+            buyCount[i] = 0;
+        }
+        if (shift > 0) {
+            std::rotate(levels.begin(), levels.begin() + k, levels.end());
+            std::rotate(buyCount.begin(), buyCount.begin() + k, buyCount.end());
+        }
+        else {
+            std::rotate(levels.begin(), levels.end() - k, levels.end());
+            std::rotate(buyCount.begin(), buyCount.end() - k, buyCount.end());
+        }
+
+        band.minTick = newMinTick;
+        band.maxTick = (price_t)(newMinTick + (long long)band.nLevels - 1);
+        occupied.clear();
+        for (size_t i = 0; i < band.nLevels; ++i) {
+            if (levels[i].activeCount) {
+                occupied.set(i);
+            }
+        }
+        // Either best may have been evicted: search both afresh.
+        bestBidIdx = band.nLevels - 1;
+        bestAskIdx = 0;
+        seekBest(Side::Buy);
+        seekBest(Side::Sell);
+    }
+
     void clear() {
+        if (deltasOn) {
+            for (size_t i = occupied.next(0); i != LevelBitmap::npos; i = occupied.next(i + 1)) {
+                touch(i);
+            }
+        }
         for (auto &pl : levels) {
-            pl.orders.clear(); 
-            pl.free_list.clear();
-            pl.totalVolume = 0; 
-            pl.activeCount = 0;
+            pl.clear();
         }
         idMap.clear();
+        occupied.clear();
+        std::fill(buyCount.begin(), buyCount.end(), 0);
         bestBidIdx = 0; 
         bestAskIdx = 0;
     }
 
 private:
-    price_t minTick, maxTick;
-    size_t nLevels;
-    std::vector<PriceLevel> levels;
-    std::unordered_map<id_t, Meta> idMap;
+    Band band;
+    typename Band::Levels levels;
+    IdTable<Meta> idMap;
+    typename Band::Bitmap occupied;
+    typename Band::Counts buyCount{};    // buy orders per level; the rest of activeCount are sells
+    // Best level of each side while that side has orders (see bestIdx());
+    // meaningless while it has none.
     size_t bestBidIdx = 0, bestAskIdx = 0;
+    uint32_t nextGen = 0;                // last handle generation issued; never reset
+
+    bool deltasOn = false;
+    std::vector<uint8_t> dirty;          // per level, while deltasOn
+    std::vector<idx_t> touched;          // levels changed since the last flush
+    std::vector<LevelDelta> carried;     // deltas fixed before a window shift
+
+    void init(size_t reserve_per_level) {
+        if constexpr (!Band::fixed) {
+            levels.resize(band.nLevels);
+            occupied.resize(band.nLevels);
+            buyCount.resize(band.nLevels, 0);
+        }
+        for (auto &pl : levels) {
+            pl.reserve(reserve_per_level);
+        }
+    }
+
+    // Unlinks an active order and keeps the level totals, bitmap, id index
+    // and best indices in step.
+    void removeSlot(size_t li, idx_t slot, id_t id, Side s) {
+        PriceLevel &pl = levels[li];
+        pl.totalVolume -= pl.qtyAt(slot);
+        if (--pl.activeCount == 0) {
+            occupied.reset(li);
+        }
+        if (s == Side::Buy) {
+            buyCount[li]--;
+        }
+        touch(li);
+        pl.freeSlot(slot);
+        idMap.erase(id);
+        updateBestOnDelete(idxToPrice(li), s);
+    }
+
+    // Removes the side-s orders on level li and returns how many there were.
+    // A level holding only that side (always, in an uncrossed book) is
+    // cleared in one go; otherwise those orders are freed one by one.
+    size_t cancelLevel(size_t li, Side s) {
+        PriceLevel &pl = levels[li];
+        size_t n = sideCount(li, s);
+        if (n == pl.activeCount) {
+            for (idx_t slot = pl.head; slot != NIL_IDX; slot = pl.orders[slot].next) {
+                idMap.erase(pl.idAt(slot));
+            }
+            pl.clear();
+            occupied.reset(li);
+        }
+        else {
+            for (idx_t slot = pl.head; slot != NIL_IDX;) {
+                idx_t next = pl.orders[slot].next;
+                if (pl.sideAt(slot) == s) {
+                    idMap.erase(pl.idAt(slot));
+                    pl.totalVolume -= pl.qtyAt(slot);
+                    pl.activeCount--;
+                    pl.freeSlot(slot);
+                }
+                slot = next;
+            }
+        }
+        if (s == Side::Buy) {
+            buyCount[li] = 0;
+        }
+        touch(li);
+        return n;
+    }
+
+    // Best level that an order of side s would trade against.
+    size_t firstOpposite(Side s) const {
+        return bestIdx(s == Side::Buy ? Side::Sell : Side::Buy);
+    }
+
+    // Side-s orders resting on level i.
+    uint32_t sideCount(size_t i, Side s) const {
+        return s == Side::Buy ? buyCount[i] : levels[i].activeCount - buyCount[i];
+    }
+
+    // Best level holding side-s orders, or npos if that side is empty.
+    size_t bestIdx(Side s) const {
+        size_t i = (s == Side::Buy) ? bestBidIdx : bestAskIdx;
+        return sideCount(i, s) ? i : LevelBitmap::npos;
+    }
+
+    // FOK pre-check: walks the same queues match() would, without changing them.
+    bool canFill(const Order& o, size_t maxFills) const {
+        const bool buy = o.side == Side::Buy;
+        const size_t limit = idxForPrice(o.price);
+        qty_t remaining = o.qty;
+        size_t fillsNeeded = 0;
+        for (size_t li = firstOpposite(o.side); li != LevelBitmap::npos && (buy ? li <= limit : li >= limit);
+             li = buy ? occupied.next(li + 1) : (li == 0 ? LevelBitmap::npos : occupied.prev(li - 1))) {
+            const PriceLevel &pl = levels[li];
+            for (idx_t slot = pl.head; slot != NIL_IDX; slot = pl.orders[slot].next) {
+                if (pl.sideAt(slot) == o.side) {
+                    continue;
+                }
+                if (++fillsNeeded > maxFills) {
+                    return false;
+                }
+                if (pl.qtyAt(slot) >= remaining) {
+                    return true;
+                }
+                remaining -= pl.qtyAt(slot);
+            }
+        }
+        return false;
+    }
+
+    // One step of process()'s prefetch pipeline. Addresses may be stale by
+    // the time the event is applied; that only costs a wasted prefetch.
+    template <typename Ev>
+    void prefetchStage(const Ev& e, int stage) const {
+        using Type = decltype(e.type);
+        if (e.type == Type::Insert) {
+            price_t p = (price_t)e.price;
+            if (!inRange(p)) {
+                return;
+            }
+            const PriceLevel &pl = levels[idxForPrice(p)];
+            if (stage == 0) {
+                __builtin_prefetch(&pl);
+            }
+            else if (stage == 1) {
+                idx_t slot = pl.free_list.empty() ? (idx_t)pl.orders.size() : pl.free_list.back();
+                if (slot < pl.orders.capacity()) {
+                    __builtin_prefetch(pl.orders.data() + slot, 1);
+                }
+                if (pl.tail != NIL_IDX) {
+                    __builtin_prefetch(pl.orders.data() + pl.tail, 1);
+                }
+            }
+            return;
+        }
+        if (e.type != Type::Amend && e.type != Type::Delete) {
+            return;
+        }
+        if (stage == 0) {
+            idMap.prefetch(e.id);
+            return;
+        }
+        const Meta* m = idMap.find(e.id);
+        if (!m) {
+            return;
+        }
+        const PriceLevel &pl = levels[idxForPrice(m->price)];
+        if (stage == 1) {
+            __builtin_prefetch(&pl);
+        }
+        else if (m->idx < pl.orders.size()) {
+            __builtin_prefetch(pl.orders.data() + m->idx, 1);
+        }
+    }
+
+    inline void touch(size_t i) {
+        if (deltasOn && !dirty[i]) {
+            dirty[i] = 1;
+            touched.push_back((idx_t)i);
+        }
+    }
 
     inline bool inRange(price_t p) const { 
-        bool result = p >= minTick && p <= maxTick; 
+        bool result = p >= band.minTick && p <= band.maxTick; 
         return result;
     }
 
     inline size_t idxForPrice(price_t p) const { 
-        return (size_t)(p - minTick); 
+        return (size_t)(p - band.minTick); 
     }
 
     inline price_t idxToPrice(size_t i) const {
-        return (price_t)(i + minTick);
+        return (price_t)(i + band.minTick);
     }
 
+    // Levels are shared by both sides, so whether a side still has an order
+    // at its best level is read from buyCount, not activeCount.
     void updateBestOnInsert(price_t p, Side s) {
         size_t idx = idxForPrice(p);
         if (s == Side::Buy) {
-            bestBidIdx = std::max(bestBidIdx, idx);
+            if (idx > bestBidIdx || !buyCount[bestBidIdx]) {
+                bestBidIdx = idx;
+            }
         } 
-        else if (levels[bestAskIdx].activeCount == 0 || idx < bestAskIdx) {
+        else if (idx < bestAskIdx || sideCount(bestAskIdx, Side::Sell) == 0) {
             bestAskIdx = idx;
         }
     }
 
     void updateBestOnDelete(price_t p, Side s) {
         size_t idx = idxForPrice(p);
-        if (s == Side::Buy && levels[idx].activeCount == 0 && idx == bestBidIdx){
-            while (bestBidIdx > 0 && levels[bestBidIdx].activeCount == 0){
-                --bestBidIdx;
+        if (idx == (s == Side::Buy ? bestBidIdx : bestAskIdx) && sideCount(idx, s) == 0) {
+            seekBest(s);
+        }
+    }
+
+    // Moves side s's best index away from the spread to the first occupied
+    // level (the current one included) that still holds side-s orders, via
+    // the bitmap; in an uncrossed book that is the first occupied level. If
+    // there is none it stops at the far end of the book.
+    void seekBest(Side s) {
+        if (s == Side::Buy) {
+            size_t i = occupied.prev(bestBidIdx);
+            while (i != LevelBitmap::npos && !buyCount[i]) {
+                i = (i == 0) ? LevelBitmap::npos : occupied.prev(i - 1);
             }
+            bestBidIdx = (i == LevelBitmap::npos) ? 0 : i;
         }
-        else if (s == Side::Sell && levels[idx].activeCount == 0 && idx == bestAskIdx){
-            while (bestAskIdx + 1 < nLevels && levels[bestAskIdx].activeCount == 0){
-                ++bestAskIdx;
+        else {
+            size_t i = occupied.next(bestAskIdx);
+            while (i != LevelBitmap::npos && sideCount(i, Side::Sell) == 0) {
+                i = occupied.next(i + 1);
             }
+            bestAskIdx = (i == LevelBitmap::npos) ? band.nLevels - 1 : i;
         }
     }
 };
 
+using OrderBook = BasicOrderBook<DynamicBand>;
+
+template <price_t MinTick, price_t MaxTick>
+using FixedOrderBook = BasicOrderBook<FixedBand<MinTick, MaxTick>>;
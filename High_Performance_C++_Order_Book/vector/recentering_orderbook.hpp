@@ -0,0 +1,203 @@
+#pragma once
+#include "orderbook.hpp"
+#include <map>
+#include <unordered_map>
+
+
+// Dense OrderBook window that follows the market. Orders inside the window go
+// to the dense book; orders outside it are parked in per-side sparse maps.
+// When the mid drifts more than halfWidth/2 from the window centre, the window
+// is re-centred on the mid (OrderBook::shiftWindow, which only rotates level
+// buffers), levels that fall off are parked, and parked orders that are now in
+// range are promoted back in time priority.
+class RecenteringOrderBook {
+public:
+    RecenteringOrderBook(price_t center, price_t halfWidth, size_t reserve_per_level = 8)
+        : book(center - halfWidth, center + halfWidth, reserve_per_level), halfWidth(halfWidth) {
+        if (halfWidth <= 0) {
+            throw std::runtime_error("invalid window width");
+        }
+        parked.reserve(1 << 16);
+    }
+
+    bool newOrder(const Order& o) {
+        if (o.qty == 0) {
+            return false;
+        }
+        if (o.price >= book.minPrice() && o.price <= book.maxPrice()) {
+            if (parked.count(o.id) || !book.newOrder(o)) {
+                return false;
+            }
+        }
+        else if (parked.count(o.id) || book.contains(o.id)) {
+            return false;
+        }
+        else {
+            park(o);
+        }
+        maybeRecenter();
+        return true;
+    }
+
+    bool amendOrder(id_t id, qty_t newQty) {
+        auto it = parked.find(id);
+        if (it == parked.end()) {
+            bool ok = book.amendOrder(id, newQty);
+            if (ok && newQty == 0) {
+                maybeRecenter();
+            }
+            return ok;
+        }
+        if (newQty == 0) {
+            return deleteOrder(id);
+        }
+        it->second->second.qty = newQty;
+        return true;
+    }
+
+    bool deleteOrder(id_t id) {
+        auto it = parked.find(id);
+        if (it == parked.end()) {
+            if (!book.deleteOrder(id)) {
+                return false;
+            }
+        }
+        else {
+            sideMap(it->second->second.side).erase(it->second);
+            parked.erase(it);
+        }
+        maybeRecenter();
+        return true;
+    }
+
+    // Best level over the dense window and the parked orders.
+    PriceLevelSummary topOfBook(Side s) const {
+        PriceLevelSummary ret = book.topOfBook(s);
+        const Parked &m = sideMap(s);
+        if (m.empty()) {
+            return ret;
+        }
+        price_t p = (s == Side::Buy) ? std::prev(m.end())->first : m.begin()->first;
+        bool better = (s == Side::Buy) ? p > ret.price : p < ret.price;
+        if (ret.orderCount == 0 || better) {
+            ret = PriceLevelSummary();
+            ret.price = p;
+            auto range = m.equal_range(p);
+            for (auto it = range.first; it != range.second; ++it) {
+                ret.totalQty += it->second.qty;
+                ret.orderCount++;
+            }
+        }
+        return ret;
+    }
+
+    size_t orderCount(price_t p) const {
+        if (p >= book.minPrice() && p <= book.maxPrice()) {
+            return book.orderCount(p);
+        }
+        return bids.count(p) + asks.count(p);
+    }
+
+    qty_t totalVolume(price_t p) const {
+        if (p >= book.minPrice() && p <= book.maxPrice()) {
+            return book.totalVolume(p);
+        }
+        qty_t total = 0;
+        for (const Parked* m : {&bids, &asks}) {
+            auto range = m->equal_range(p);
+            for (auto it = range.first; it != range.second; ++it) {
+                total += it->second.qty;
+            }
+        }
+        return total;
+    }
+
+    size_t totalOrders() const {
+        return book.totalOrders() + parked.size();
+    }
+
+    size_t parkedOrders() const {
+        return parked.size();
+    }
+
+    size_t recenterCount() const {
+        return recenters;
+    }
+
+    const OrderBook& dense() const {
+        return book;
+    }
+
+    void clear() {
+        book.clear();
+        bids.clear();
+        asks.clear();
+        parked.clear();
+    }
+
+private:
+    using Parked = std::multimap<price_t, Order>;   // equal prices stay in arrival order
+
+    OrderBook book;
+    price_t halfWidth;
+    Parked bids, asks;
+    std::unordered_map<id_t, Parked::iterator> parked;
+    size_t recenters = 0;
+
+    Parked& sideMap(Side s) { return s == Side::Buy ? bids : asks; }
+    const Parked& sideMap(Side s) const { return s == Side::Buy ? bids : asks; }
+
+    void park(const Order& o) {
+        auto it = sideMap(o.side).emplace(o.price, o);
+        it->second.active = true;
+        parked.emplace(o.id, it);
+    }
+
+    // Best price of one side over dense and parked orders; false if the side
+    // is empty. Unlike topOfBook() it does not total the level.
+    bool bestPrice(Side s, price_t& out) const {
+        PriceLevelSummary top = book.topOfBook(s);
+        bool found = top.orderCount != 0;
+        out = top.price;
+        const Parked &m = sideMap(s);
+        if (!m.empty()) {
+            price_t p = (s == Side::Buy) ? std::prev(m.end())->first : m.begin()->first;
+            if (!found || ((s == Side::Buy) ? p > out : p < out)) {
+                out = p;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    void maybeRecenter() {
+        price_t bid = 0, ask = 0;
+        bool hasBid = bestPrice(Side::Buy, bid);
+        bool hasAsk = bestPrice(Side::Sell, ask);
+        if (!hasBid && !hasAsk) {
+            return;
+        }
+        long long mid = !hasBid ? ask
+                      : !hasAsk ? bid
+                      : ((long long)bid + ask) / 2;
+        long long center = (long long)book.minPrice() + halfWidth;
+        long long drift = mid > center ? mid - center : center - mid;
+        if (drift > halfWidth / 2) {
+            recenter((price_t)mid);
+        }
+    }
+
+    void recenter(price_t mid) {
+        recenters++;
+        book.shiftWindow(mid - halfWidth, [&](const Order& o) { park(o); });
+        for (Parked* m : {&bids, &asks}) {
+            auto first = m->lower_bound(book.minPrice());
+            auto last = m->upper_bound(book.maxPrice());
+            for (auto it = first; it != last; ++it) {
+                parked.erase(it->second.id);
+                book.newOrder(it->second);
+            }
+            m->erase(first, last);
+        }
+    }
+};
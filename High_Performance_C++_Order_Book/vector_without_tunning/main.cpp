@@ -1,4 +1,5 @@
 #include "orderbook copy.hpp"
+#include "../benchmark_driver.hpp"
 #include <chrono>
 #include <random>
 #include <iostream>
@@ -206,12 +207,34 @@ void benchmark_run(size_t N = 1'000'000) {
          << "99th: " << latencies[(int)(0.99 * latencies.size())] << " ns\n";
 }
 
-int main() {
+// Adapter for the shared comparison driver (../benchmark_driver.hpp).
+struct ComparisonBook {
+    OrderBook ob;
+    bool insert(const bench::Event& e) {
+        Order o;
+        o.id = e.id;
+        o.price = (price_t)e.price;
+        o.qty = (qty_t)e.qty;
+        o.side = e.buy ? Side::Buy : Side::Sell;
+        return ob.newOrder(o);
+    }
+    bool amend(const bench::Event& e) { return ob.amendOrder(e.id, e.qty); }
+    bool remove(const bench::Event& e) { return ob.deleteOrder(e.id); }
+    uint64_t top() { return (uint64_t)ob.topOfBook(Side::Buy).price + ob.topOfBook(Side::Sell).price; }
+};
+
+// Optional argument: an event log (see ../event_log.hpp) to replay instead.
+void benchmark_compare(const std::string& logPath = "") {
+    bench::replayComparison<ComparisonBook>("vector_without_tunning", logPath, "../benchmark_comparison.csv");
+}
+
+int main(int argc, char** argv) {
     std::ios::sync_with_stdio(false);
     std::cin.tie(nullptr);
 
     //unit_tests();
     benchmark_run(1'000'000);
+    benchmark_compare(argc > 1 ? argv[1] : "");
     // OrderBook ob(0, 1000);
     // Order o;
     // for (size_t i = 0; i < 1; ++i) {